@@ -2,6 +2,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 static uint16_t crc16_update(uint16_t crc, uint8_t data) {
     crc ^= data;
@@ -23,6 +24,7 @@ static uint16_t calculate_crc16(const uint8_t* data, size_t length) {
     return crc;
 }
 
+#ifndef CDEX_NO_HEAP // 描述字符串只在动态注册时解析
 static cdex_data_type_t str_to_type(const char* str, size_t* size) {
     if (strcmp(str, "u8") == 0) { *size = 1; return CDEX_TYPE_U8; }
     if (strcmp(str, "i8") == 0) { *size = 1; return CDEX_TYPE_I8; }
@@ -34,14 +36,46 @@ static cdex_data_type_t str_to_type(const char* str, size_t* size) {
     if (strcmp(str, "i64") == 0) { *size = 8; return CDEX_TYPE_I64; }
     if (strcmp(str, "f32") == 0) { *size = 4; return CDEX_TYPE_F32; }
     if (strcmp(str, "d64") == 0) { *size = 8; return CDEX_TYPE_D64; }
-    // variable-sized types
+    if (strcmp(str, "f16") == 0) { *size = 2; return CDEX_TYPE_F16; }
+    if (strcmp(str, "s8") == 0) { *size = 1; return CDEX_TYPE_S8; }
+    if (strcmp(str, "s16") == 0) { *size = 2; return CDEX_TYPE_S16; }
+    if (strcmp(str, "s32") == 0) { *size = 4; return CDEX_TYPE_S32; }
+    // variable-sized and sub-byte types
     *size = 0;
     if (strcmp(str, "num") == 0) { return CDEX_TYPE_NUM; }
     if (strcmp(str, "bin") == 0) { return CDEX_TYPE_BIN; }
     if (strcmp(str, "str") == 0) { return CDEX_TYPE_STR; }
+    if (strcmp(str, "dstr") == 0) { return CDEX_TYPE_DSTR; }
+    if (strcmp(str, "b1") == 0) { return CDEX_TYPE_B1; }
+    if (str[0] == 'u' && str[1] >= '1' && str[1] <= '7' && str[2] == '\0') {
+        return (cdex_data_type_t)(CDEX_TYPE_U1 + (str[1] - '1'));
+    }
     return CDEX_TYPE_UNKNOWN;
 }
 
+/**
+ * @brief 解析段中的类型部分，例如 "u16" 或带缩放系数的 "s16:0.01"
+ */
+static void parse_field_type(const char* str, cdex_field_t* field) {
+    char type_str[8] = { 0 };
+    const char* colon = strchr(str, ':');
+    size_t type_len = colon ? (size_t)(colon - str) : strlen(str);
+    if (type_len >= sizeof(type_str)) {
+        field->type = CDEX_TYPE_UNKNOWN;
+        field->size = 0;
+        return;
+    }
+    memcpy(type_str, str, type_len);
+    size_t size = 0;
+    field->type = str_to_type(type_str, &size);
+    field->size = (uint8_t)size;
+    field->scale = 0;
+    if (field->type == CDEX_TYPE_S8 || field->type == CDEX_TYPE_S16 || field->type == CDEX_TYPE_S32) {
+        field->scale = colon ? strtod(colon + 1, NULL) : 1.0;
+    }
+}
+#endif
+
 static char *type_to_str(cdex_data_type_t type) {
     switch (type) {
         case CDEX_TYPE_U8: return "u8";
@@ -57,6 +91,19 @@ static char *type_to_str(cdex_data_type_t type) {
         case CDEX_TYPE_NUM: return "num";
         case CDEX_TYPE_BIN: return "bin";
         case CDEX_TYPE_STR: return "str";
+        case CDEX_TYPE_U1: return "u1";
+        case CDEX_TYPE_U2: return "u2";
+        case CDEX_TYPE_U3: return "u3";
+        case CDEX_TYPE_U4: return "u4";
+        case CDEX_TYPE_U5: return "u5";
+        case CDEX_TYPE_U6: return "u6";
+        case CDEX_TYPE_U7: return "u7";
+        case CDEX_TYPE_B1: return "b1";
+        case CDEX_TYPE_F16: return "f16";
+        case CDEX_TYPE_S8: return "s8";
+        case CDEX_TYPE_S16: return "s16";
+        case CDEX_TYPE_S32: return "s32";
+        case CDEX_TYPE_DSTR: return "dstr";
         default: return "unknown";
     }
 }
@@ -101,99 +148,889 @@ static uint64_t decode_varint(const uint8_t* buffer, int* decoded_len) {
     return value;
 }
 
+// --- 字符串字典 ---
+
+#define DICT_EMPTY 0xFFFF
+
+void cdex_dict_init(cdex_dict_t* dict, bool auto_add) {
+    if (!dict) return;
+    memset(dict, 0, sizeof(cdex_dict_t));
+    memset(dict->offsets, 0xFF, sizeof(dict->offsets));
+    dict->auto_add = auto_add;
+}
+
+const char* cdex_dict_get(const cdex_dict_t* dict, int index) {
+    if (!dict || index < 0 || index >= dict->count || dict->offsets[index] == DICT_EMPTY) return NULL;
+    return &dict->pool[dict->offsets[index]];
+}
+
+int cdex_dict_find(const cdex_dict_t* dict, const char* str) {
+    if (!dict || !str) return -1;
+    for (int i = 0; i < dict->count; ++i) {
+        if (dict->offsets[i] != DICT_EMPTY && strcmp(&dict->pool[dict->offsets[i]], str) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool dict_has_room(const cdex_dict_t* dict, size_t str_len) {
+    return dict->count < CDEX_DICT_MAX_ENTRIES && dict->pool_used + str_len + 1 <= CDEX_DICT_POOL_SIZE;
+}
+
+cdex_status_t cdex_dict_set(cdex_dict_t* dict, int index, const char* str) {
+    if (!dict || !str || index < 0 || index >= CDEX_DICT_MAX_ENTRIES) return CDEX_ERROR_INVALID_DATA;
+    const char* existing = cdex_dict_get(dict, index);
+    if (existing && strcmp(existing, str) == 0) return CDEX_SUCCESS;
+
+    // 字符串池只追加，被覆盖的旧条目占用的空间不回收
+    size_t str_len = strlen(str);
+    if (dict->pool_used + str_len + 1 > CDEX_DICT_POOL_SIZE) return CDEX_ERROR_PACKET_FULL;
+    memcpy(&dict->pool[dict->pool_used], str, str_len + 1);
+    dict->offsets[index] = (uint16_t)dict->pool_used;
+    dict->pool_used += str_len + 1;
+    if (index >= dict->count) dict->count = index + 1;
+    return CDEX_SUCCESS;
+}
+
+cdex_status_t cdex_dict_add(cdex_dict_t* dict, const char* str, int* index_out) {
+    if (!dict || !str) return CDEX_ERROR_INVALID_DATA;
+    int index = cdex_dict_find(dict, str);
+    if (index < 0) {
+        if (!dict_has_room(dict, strlen(str))) return CDEX_ERROR_PACKET_FULL;
+        index = dict->count;
+        cdex_status_t status = cdex_dict_set(dict, index, str);
+        if (status != CDEX_SUCCESS) return status;
+    }
+    if (index_out) *index_out = index;
+    return CDEX_SUCCESS;
+}
+
+// --- 字段编解码 ---
+
+/**
+ * @brief 按位写入的游标：相邻的位字段共享字节，整字节字段写入前自动对齐
+ */
+typedef struct {
+    uint8_t* ptr;       // 下一个空闲字节
+    uint8_t* end;
+    uint8_t* bit_byte;  // 正在填充的位字段字节
+    int bit_pos;        // bit_byte 中下一个空闲位，0 表示已对齐
+} bit_writer_t;
+
+/**
+ * @brief 按位读取的游标，与 bit_writer_t 对应
+ */
+typedef struct {
+    const uint8_t* ptr;
+    const uint8_t* end;
+    const uint8_t* bit_byte;
+    int bit_pos;
+} bit_reader_t;
+
+/**
+ * @brief 类型对应的定长字节数，变长字段和位字段为0
+ */
+static uint8_t type_size(cdex_data_type_t type) {
+    switch (type) {
+        case CDEX_TYPE_U8: case CDEX_TYPE_I8: case CDEX_TYPE_S8: return 1;
+        case CDEX_TYPE_U16: case CDEX_TYPE_I16: case CDEX_TYPE_F16: case CDEX_TYPE_S16: return 2;
+        case CDEX_TYPE_U32: case CDEX_TYPE_I32: case CDEX_TYPE_F32: case CDEX_TYPE_S32: return 4;
+        case CDEX_TYPE_U64: case CDEX_TYPE_I64: case CDEX_TYPE_D64: return 8;
+        default: return 0;
+    }
+}
+
+/**
+ * @brief 位字段的位宽，整字节类型返回0
+ */
+static int type_bits(cdex_data_type_t type) {
+    if (type >= CDEX_TYPE_U1 && type <= CDEX_TYPE_U7) return type - CDEX_TYPE_U1 + 1;
+    if (type == CDEX_TYPE_B1) return 1;
+    return 0;
+}
+
+static bool write_bits(bit_writer_t* writer, uint8_t value, int nbits) {
+    while (nbits > 0) {
+        if (writer->bit_pos == 0) {
+            if (writer->ptr >= writer->end) return false;
+            writer->bit_byte = writer->ptr++;
+            *writer->bit_byte = 0;
+        }
+        int take = 8 - writer->bit_pos < nbits ? 8 - writer->bit_pos : nbits;
+        *writer->bit_byte |= (uint8_t)((value & ((1u << take) - 1)) << writer->bit_pos);
+        value >>= take;
+        nbits -= take;
+        writer->bit_pos = (writer->bit_pos + take) & 7;
+    }
+    return true;
+}
+
+/**
+ * @brief 对齐到字节边界并预留 n 个字节
+ * @return 预留区域的起始位置，空间不足返回NULL
+ */
+static uint8_t* reserve_bytes(bit_writer_t* writer, size_t n) {
+    writer->bit_pos = 0;
+    if ((size_t)(writer->end - writer->ptr) < n) return NULL;
+    uint8_t* start = writer->ptr;
+    writer->ptr += n;
+    return start;
+}
+
+static bool read_bits(bit_reader_t* reader, int nbits, uint8_t* value) {
+    uint8_t result = 0;
+    int shift = 0;
+    while (nbits > 0) {
+        if (reader->bit_pos == 0) {
+            if (reader->ptr >= reader->end) return false;
+            reader->bit_byte = reader->ptr++;
+        }
+        int take = 8 - reader->bit_pos < nbits ? 8 - reader->bit_pos : nbits;
+        result |= (uint8_t)(((*reader->bit_byte >> reader->bit_pos) & ((1u << take) - 1)) << shift);
+        shift += take;
+        nbits -= take;
+        reader->bit_pos = (reader->bit_pos + take) & 7;
+    }
+    *value = result;
+    return true;
+}
+
+/**
+ * @brief 对齐到字节边界并消费 n 个字节
+ * @return 被消费区域的起始位置，数据不足返回NULL
+ */
+static const uint8_t* consume_bytes(bit_reader_t* reader, size_t n) {
+    reader->bit_pos = 0;
+    if ((size_t)(reader->end - reader->ptr) < n) return NULL;
+    const uint8_t* start = reader->ptr;
+    reader->ptr += n;
+    return start;
+}
+
+/**
+ * @brief 当前位置相对 base 的位偏移
+ * @param aligned 为 true 时返回下一个整字节字段的起始偏移
+ */
+static uint32_t reader_bit_offset(const bit_reader_t* reader, const uint8_t* base, bool aligned) {
+    if (aligned || reader->bit_pos == 0) return (uint32_t)(reader->ptr - base) * 8;
+    return (uint32_t)(reader->bit_byte - base) * 8 + reader->bit_pos;
+}
+
+static void reader_seek(bit_reader_t* reader, const uint8_t* base, const uint8_t* end, uint32_t bit_offset) {
+    reader->end = end;
+    reader->bit_pos = bit_offset & 7;
+    if (reader->bit_pos == 0) {
+        reader->ptr = base + bit_offset / 8;
+    } else {
+        reader->bit_byte = base + bit_offset / 8;
+        reader->ptr = reader->bit_byte + 1;
+    }
+}
+
+/**
+ * @brief 计算 Varint 占用的字节数
+ * @return 字节数，数据不完整时返回-1
+ */
+static int varint_span(const uint8_t* ptr, const uint8_t* end) {
+    for (int i = 0; i < 10 && ptr + i < end; ++i) {
+        if ((ptr[i] & 0x80) == 0) return i + 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief 计算整字节字段值在字节流中占用的字节数，不做解码
+ * @return 字节数，数据不完整时返回-1
+ */
+static int field_span(const cdex_field_t* field_desc, const uint8_t* ptr, const uint8_t* end) {
+    if (ptr >= end) return -1;
+    switch (field_desc->type) {
+        case CDEX_TYPE_STR: {
+            size_t max_len = end - ptr;
+            size_t str_len = strnlen((const char*)ptr, max_len);
+            if (str_len == max_len) return -1; // No null terminator found
+            return (int)str_len + 1;
+        }
+        case CDEX_TYPE_BIN:
+            if (ptr + 1 + ptr[0] > end) return -1;
+            return ptr[0] + 1;
+        case CDEX_TYPE_NUM:
+            return varint_span(ptr, end);
+        case CDEX_TYPE_DSTR: {
+            // 标记: 0 字面量；1 带内新增 (后跟索引)；n>=2 字典索引 n-2
+            int tag_len = varint_span(ptr, end);
+            if (tag_len < 0) return -1;
+            if (tag_len > 1 || ptr[0] >= 2) return tag_len;
+            const uint8_t* str_start = ptr + 1;
+            if (ptr[0] == 1) {
+                int index_len = varint_span(str_start, end);
+                if (index_len < 0) return -1;
+                str_start += index_len;
+            }
+            size_t max_len = end - str_start;
+            size_t str_len = strnlen((const char*)str_start, max_len);
+            if (str_len == max_len) return -1;
+            return (int)((str_start - ptr) + str_len + 1);
+        }
+        default:
+            if (ptr + field_desc->size > end) return -1;
+            return (int)field_desc->size;
+    }
+}
+
+static uint16_t float_to_half(float value) {
+    uint32_t x;
+    memcpy(&x, &value, sizeof(x));
+    uint16_t sign = (uint16_t)((x >> 16) & 0x8000);
+    uint32_t float_exp = (x >> 23) & 0xFF;
+    uint32_t mant = x & 0x7FFFFF;
+    if (float_exp == 0xFF) return sign | 0x7C00 | (mant ? 0x200 : 0); // Inf / NaN
+    int32_t exp = (int32_t)float_exp - 127 + 15;
+    if (exp >= 31) return sign | 0x7C00; // 溢出为 Inf
+    if (exp <= 0) {
+        // 非规格化数
+        if (exp < -10) return sign;
+        mant |= 0x800000;
+        int shift = 14 - exp;
+        uint32_t half_mant = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half_mant & 1))) half_mant++;
+        return sign | (uint16_t)half_mant;
+    }
+    uint32_t half = ((uint32_t)exp << 10) | (mant >> 13);
+    uint32_t rem = mant & 0x1FFF;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) half++; // 进位可能进入指数，结果仍然正确
+    return sign | (uint16_t)half;
+}
+
+static float half_to_float(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exp = (half >> 10) & 0x1F;
+    uint32_t mant = half & 0x3FF;
+    uint32_t x;
+    if (exp == 0) {
+        if (mant == 0) {
+            x = sign;
+        } else {
+            exp = 127 - 15 + 1;
+            while (!(mant & 0x400)) {
+                mant <<= 1;
+                exp--;
+            }
+            x = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+        }
+    } else if (exp == 31) {
+        x = sign | 0x7F800000 | (mant << 13);
+    } else {
+        x = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+    }
+    float value;
+    memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+static double field_scale(const cdex_field_t* field_desc) {
+    return field_desc->scale != 0 ? field_desc->scale : 1.0;
+}
+
+/**
+ * @brief 定点数编码：按 scale 缩放后四舍五入，超出范围时取边界值
+ */
+static int32_t scaled_to_raw(const cdex_field_t* field_desc, double value) {
+    double max = field_desc->size == 1 ? INT8_MAX : (field_desc->size == 2 ? INT16_MAX : INT32_MAX);
+    double raw = round(value / field_scale(field_desc));
+    if (raw != raw) return 0; // NaN
+    if (raw > max) raw = max;
+    if (raw < -max - 1) raw = -max - 1;
+    return (int32_t)raw;
+}
+
+static double raw_to_scaled(const cdex_field_t* field_desc, const uint8_t* ptr) {
+    int32_t raw;
+    switch (field_desc->size) {
+        case 1: { int8_t v; memcpy(&v, ptr, 1); raw = v; break; }
+        case 2: { int16_t v; memcpy(&v, ptr, 2); raw = v; break; }
+        default: memcpy(&raw, ptr, 4); break;
+    }
+    return raw * field_scale(field_desc);
+}
+
+/**
+ * @brief 编码单个字段值
+ * @return 成功返回 true，空间不足或 u1~u7 的值超出位宽时返回 false
+ */
+static bool encode_field(bit_writer_t* writer, const cdex_field_t* field_desc, const cdex_value_t* value,
+                         cdex_dict_t* dict) {
+    int bits = type_bits(field_desc->type);
+    if (bits) {
+        // 高位直接截掉会让接收端读到另一个值，宁可拒绝 (b1 按真假编码，不受此限)
+        if (field_desc->type != CDEX_TYPE_B1 && (value->u8 >> bits) != 0) return false;
+        return write_bits(writer, field_desc->type == CDEX_TYPE_B1 ? (value->u8 != 0) : value->u8, bits);
+    }
+
+    uint8_t* ptr;
+    switch (field_desc->type) {
+        case CDEX_TYPE_STR: {
+            size_t str_len = strlen(value->str) + 1; // +1 for null terminator
+            if (!(ptr = reserve_bytes(writer, str_len))) return false;
+            memcpy(ptr, value->str, str_len);
+            return true;
+        }
+        case CDEX_TYPE_BIN:
+            if (!(ptr = reserve_bytes(writer, value->bin[0] + 1))) return false;
+            memcpy(ptr, value->bin, value->bin[0] + 1);
+            return true;
+        case CDEX_TYPE_NUM: {
+            uint8_t varint_buffer[10];
+            int varint_size = encode_varint(varint_buffer, zigzag_encode_64(value->i64));
+            if (!(ptr = reserve_bytes(writer, varint_size))) return false;
+            memcpy(ptr, varint_buffer, varint_size);
+            return true;
+        }
+        case CDEX_TYPE_DSTR: {
+            uint8_t head[11];
+            int head_len;
+            int index = cdex_dict_find(dict, value->str);
+            if (index >= 0) {
+                head_len = encode_varint(head, (uint64_t)index + 2);
+                if (!(ptr = reserve_bytes(writer, head_len))) return false;
+                memcpy(ptr, head, head_len);
+                return true;
+            }
+            size_t str_len = strlen(value->str) + 1;
+            if (dict && dict->auto_add && cdex_dict_add(dict, value->str, &index) == CDEX_SUCCESS) {
+                head[0] = 1;
+                head_len = 1 + encode_varint(head + 1, (uint64_t)index);
+            } else {
+                head[0] = 0;
+                head_len = 1;
+            }
+            if (!(ptr = reserve_bytes(writer, head_len + str_len))) return false;
+            memcpy(ptr, head, head_len);
+            memcpy(ptr + head_len, value->str, str_len);
+            return true;
+        }
+        case CDEX_TYPE_F16: {
+            uint16_t half = float_to_half(value->f32);
+            if (!(ptr = reserve_bytes(writer, 2))) return false;
+            memcpy(ptr, &half, 2);
+            return true;
+        }
+        case CDEX_TYPE_S8:
+        case CDEX_TYPE_S16:
+        case CDEX_TYPE_S32: {
+            int32_t raw = scaled_to_raw(field_desc, value->d64);
+            if (!(ptr = reserve_bytes(writer, field_desc->size))) return false;
+            memcpy(ptr, &raw, field_desc->size);
+            return true;
+        }
+        default:
+            if (!(ptr = reserve_bytes(writer, field_desc->size))) return false;
+            memcpy(ptr, value, field_desc->size);
+            return true;
+    }
+}
+
+/**
+ * @brief 解码 dstr 字段
+ */
+static cdex_status_t decode_dict_string(const uint8_t* ptr, cdex_value_t* value_out, bool copy_dynamic,
+                                        cdex_dict_t* dict, bool* borrowed) {
+    int tag_len = 0;
+    uint64_t tag = decode_varint(ptr, &tag_len);
+    if (tag >= 2) {
+        if (tag - 2 >= CDEX_DICT_MAX_ENTRIES) return CDEX_ERROR_INVALID_DATA;
+        const char* entry = cdex_dict_get(dict, (int)(tag - 2));
+        if (!entry) return CDEX_ERROR_INVALID_DATA; // 字典不同步
+        value_out->str = (char*)entry;
+        *borrowed = true;
+        return CDEX_SUCCESS;
+    }
+
+    const char* literal = (const char*)ptr + tag_len;
+    if (tag == 1) {
+        int index_len = 0;
+        uint64_t index = decode_varint((const uint8_t*)literal, &index_len);
+        if (index >= CDEX_DICT_MAX_ENTRIES) return CDEX_ERROR_INVALID_DATA;
+        literal += index_len;
+        // 只有会修改状态的完整解析才接收带内新增的条目
+        if (copy_dynamic && dict) {
+            // 无法写入时报错，退回字面量会让收发双方的字典悄悄失步
+            cdex_status_t status = cdex_dict_set(dict, (int)index, literal);
+            if (status != CDEX_SUCCESS) return status;
+            value_out->str = (char*)cdex_dict_get(dict, (int)index);
+            *borrowed = true;
+            return CDEX_SUCCESS;
+        }
+    }
+#ifndef CDEX_NO_HEAP
+    if (!copy_dynamic) {
+#endif
+        value_out->str = (char*)literal;
+        *borrowed = true;
+        return CDEX_SUCCESS;
+#ifndef CDEX_NO_HEAP
+    }
+    size_t str_len = strlen(literal) + 1;
+    value_out->str = (char*)malloc(str_len);
+    if (!value_out->str) return CDEX_ERROR_MEMORY_ALLOCATION;
+    memcpy(value_out->str, literal, str_len);
+    return CDEX_SUCCESS;
+#endif
+}
+
+/**
+ * @brief 解码单个字段值
+ * @param copy_dynamic 为 true 时为 str/bin 分配内存拷贝，否则返回指向字节流的视图
+ * @param dict dstr 字段使用的字典，可为NULL
+ * @param borrowed [out] 解码结果指向共享存储、不需要释放时置为 true
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+static cdex_status_t decode_field(bit_reader_t* reader, const cdex_field_t* field_desc, cdex_value_t* value_out,
+                                  bool copy_dynamic, cdex_dict_t* dict, bool* borrowed) {
+    *borrowed = false;
+    int bits = type_bits(field_desc->type);
+    if (bits) {
+        if (!read_bits(reader, bits, &value_out->u8)) return CDEX_ERROR_BUFFER_TOO_SMALL;
+        return CDEX_SUCCESS;
+    }
+
+    reader->bit_pos = 0;
+    int span = field_span(field_desc, reader->ptr, reader->end);
+    if (span < 0) {
+        bool is_string = field_desc->type == CDEX_TYPE_STR || field_desc->type == CDEX_TYPE_DSTR;
+        return is_string ? CDEX_ERROR_INVALID_DATA : CDEX_ERROR_BUFFER_TOO_SMALL;
+    }
+    const uint8_t* ptr = consume_bytes(reader, span);
+
+    switch (field_desc->type) {
+        case CDEX_TYPE_STR:
+        case CDEX_TYPE_BIN: {
+            uint8_t* data = (uint8_t*)ptr;
+#ifndef CDEX_NO_HEAP
+            if (copy_dynamic) {
+                data = (uint8_t*)malloc(span);
+                if (!data) return CDEX_ERROR_MEMORY_ALLOCATION;
+                memcpy(data, ptr, span);
+            }
+#endif
+            if (field_desc->type == CDEX_TYPE_STR) {
+                value_out->str = (char*)data;
+            } else {
+                value_out->bin = data;
+            }
+            *borrowed = data == ptr;
+            return CDEX_SUCCESS;
+        }
+        case CDEX_TYPE_DSTR:
+            return decode_dict_string(ptr, value_out, copy_dynamic, dict, borrowed);
+        case CDEX_TYPE_NUM: {
+            int varint_size = 0;
+            value_out->i64 = zigzag_decode_64(decode_varint(ptr, &varint_size));
+            return CDEX_SUCCESS;
+        }
+        case CDEX_TYPE_F16: {
+            uint16_t half;
+            memcpy(&half, ptr, 2);
+            value_out->f32 = half_to_float(half);
+            return CDEX_SUCCESS;
+        }
+        case CDEX_TYPE_S8:
+        case CDEX_TYPE_S16:
+        case CDEX_TYPE_S32:
+            value_out->d64 = raw_to_scaled(field_desc, ptr);
+            return CDEX_SUCCESS;
+        default:
+            memcpy(value_out, ptr, span);
+            return CDEX_SUCCESS;
+    }
+}
+
+/**
+ * @brief 跳过单个字段，不做解码
+ */
+static bool skip_field(bit_reader_t* reader, const cdex_field_t* field_desc) {
+    int bits = type_bits(field_desc->type);
+    if (bits) {
+        uint8_t discard;
+        return read_bits(reader, bits, &discard);
+    }
+    reader->bit_pos = 0;
+    int span = field_span(field_desc, reader->ptr, reader->end);
+    return span >= 0 && consume_bytes(reader, span) != NULL;
+}
+
+/**
+ * @brief 不解码地把单个字段从源字节流拷贝到目标字节流
+ */
+static bool copy_field(bit_reader_t* reader, bit_writer_t* writer, const cdex_field_t* field_desc) {
+    int bits = type_bits(field_desc->type);
+    if (bits) {
+        uint8_t value;
+        return read_bits(reader, bits, &value) && write_bits(writer, value, bits);
+    }
+    reader->bit_pos = 0;
+    int span = field_span(field_desc, reader->ptr, reader->end);
+    if (span < 0) return false;
+    const uint8_t* src = consume_bytes(reader, span);
+    uint8_t* dst = reserve_bytes(writer, span);
+    if (!dst) return false;
+    memcpy(dst, src, span);
+    return true;
+}
+
+/**
+ * @brief 判断 dstr 字段是否带有带内新增的字典条目 (标记为1)
+ */
+static bool is_dict_add(const uint8_t* ptr, const uint8_t* end) {
+    int tag_len = 0;
+    return varint_span(ptr, end) > 0 && decode_varint(ptr, &tag_len) == 1;
+}
+
 // --- 描述符管理 ---
-static cdex_descriptor_node_t* g_descriptor_list_head = NULL;
+
+#ifdef CDEX_NO_HEAP
+static cdex_descriptor_node_t g_descriptor_pool[CDEX_MAX_DESCRIPTORS];
+static int g_descriptor_pool_used = 0;
+#else
+/*
+ * 动态注册的描述符按ID放在开放寻址哈希表中 (线性探测，负载不超过1/2)；
+ * 字段名放在分块分配的共享名称池中，相同的名称只保存一份。
+ */
+static cdex_descriptor_node_t** g_descriptor_index = NULL;
+static size_t g_descriptor_index_capacity = 0; // 2的幂
+static size_t g_descriptor_count = 0;
+
+#define NAME_CHUNK_SIZE 4096
+
+typedef struct name_chunk {
+    struct name_chunk* next;
+    size_t used;
+    char data[NAME_CHUNK_SIZE];
+} name_chunk_t;
+
+static name_chunk_t* g_name_chunks = NULL;
+static const char** g_name_index = NULL;
+static size_t g_name_index_capacity = 0; // 2的幂
+static size_t g_name_count = 0;
+#endif
+
+static void transcoders_cleanup(void);
 
 void cdex_manager_init(void) {
     cdex_manager_cleanup();
 }
 
 void cdex_manager_cleanup(void) {
-    cdex_descriptor_node_t* current = g_descriptor_list_head;
-    while (current != NULL) {
-        cdex_descriptor_node_t* next = current->next;
-        // 释放动态分配的描述符字符串
-        if (current->descriptor.raw_string) {
-            free(current->descriptor.raw_string);
+#ifdef CDEX_NO_HEAP
+    g_descriptor_pool_used = 0;
+#else
+    for (size_t i = 0; i < g_descriptor_index_capacity; ++i) {
+        free(g_descriptor_index[i]); // 字段表与节点一起分配
+    }
+    free(g_descriptor_index);
+    g_descriptor_index = NULL;
+    g_descriptor_index_capacity = 0;
+    g_descriptor_count = 0;
+
+    while (g_name_chunks != NULL) {
+        name_chunk_t* next = g_name_chunks->next;
+        free(g_name_chunks);
+        g_name_chunks = next;
+    }
+    free(g_name_index);
+    g_name_index = NULL;
+    g_name_index_capacity = 0;
+    g_name_count = 0;
+#endif
+    transcoders_cleanup();
+}
+
+#ifndef CDEX_NO_HEAP
+static size_t id_slot(uint16_t id, size_t capacity) {
+    return ((uint32_t)id * 40503u) & (capacity - 1); // 40503 ≈ 2^16 / 黄金分割比
+}
+
+static bool index_descriptor_node(cdex_descriptor_node_t* node) {
+    if ((g_descriptor_count + 1) * 2 > g_descriptor_index_capacity) {
+        size_t capacity = g_descriptor_index_capacity ? g_descriptor_index_capacity * 2 : 16;
+        cdex_descriptor_node_t** index = (cdex_descriptor_node_t**)calloc(capacity, sizeof(cdex_descriptor_node_t*));
+        if (!index) return false;
+        for (size_t i = 0; i < g_descriptor_index_capacity; ++i) {
+            cdex_descriptor_node_t* old = g_descriptor_index[i];
+            if (!old) continue;
+            size_t slot = id_slot(old->descriptor.id, capacity);
+            while (index[slot]) slot = (slot + 1) & (capacity - 1);
+            index[slot] = old;
         }
-        // 释放节点本身
-        free(current);
-        current = next;
+        free(g_descriptor_index);
+        g_descriptor_index = index;
+        g_descriptor_index_capacity = capacity;
     }
-    g_descriptor_list_head = NULL;
+    size_t slot = id_slot(node->descriptor.id, g_descriptor_index_capacity);
+    while (g_descriptor_index[slot]) slot = (slot + 1) & (g_descriptor_index_capacity - 1);
+    g_descriptor_index[slot] = node;
+    g_descriptor_count++;
+    return true;
 }
 
-const cdex_descriptor_t* cdex_get_descriptor_by_id(uint16_t id) {
-    if (!g_descriptor_list_head) return NULL;
-    cdex_descriptor_node_t* current = g_descriptor_list_head;
-    while (current != NULL) {
-        if (current->descriptor.id == id) {
-            return &current->descriptor;
+static uint32_t name_hash(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void name_index_insert(const char** index, size_t capacity, const char* name) {
+    size_t slot = name_hash(name, strlen(name)) & (capacity - 1);
+    while (index[slot]) slot = (slot + 1) & (capacity - 1);
+    index[slot] = name;
+}
+
+/**
+ * @brief 在共享名称池中查找或加入一个字段名
+ * @param name 名称，不要求以 '\0' 结尾
+ * @param len 名称长度，超过 CDEX_FIELD_NAME_LEN - 1 的部分被截断
+ * @return 池中以 '\0' 结尾的名称，内存不足时返回NULL
+ */
+static const char* intern_name(const char* name, size_t len) {
+    if (len > CDEX_FIELD_NAME_LEN - 1) len = CDEX_FIELD_NAME_LEN - 1;
+    uint32_t hash = name_hash(name, len);
+    if (g_name_index_capacity) {
+        size_t slot = hash & (g_name_index_capacity - 1);
+        while (g_name_index[slot]) {
+            const char* entry = g_name_index[slot];
+            if (strncmp(entry, name, len) == 0 && entry[len] == '\0') return entry;
+            slot = (slot + 1) & (g_name_index_capacity - 1);
+        }
+    }
+
+    if ((g_name_count + 1) * 2 > g_name_index_capacity) {
+        size_t capacity = g_name_index_capacity ? g_name_index_capacity * 2 : 64;
+        const char** index = (const char**)calloc(capacity, sizeof(const char*));
+        if (!index) return NULL;
+        for (size_t i = 0; i < g_name_index_capacity; ++i) {
+            if (g_name_index[i]) name_index_insert(index, capacity, g_name_index[i]);
+        }
+        free(g_name_index);
+        g_name_index = index;
+        g_name_index_capacity = capacity;
+    }
+    if (!g_name_chunks || g_name_chunks->used + len + 1 > NAME_CHUNK_SIZE) {
+        name_chunk_t* chunk = (name_chunk_t*)malloc(sizeof(name_chunk_t));
+        if (!chunk) return NULL;
+        chunk->next = g_name_chunks;
+        chunk->used = 0;
+        g_name_chunks = chunk;
+    }
+    char* entry = g_name_chunks->data + g_name_chunks->used;
+    memcpy(entry, name, len);
+    entry[len] = '\0';
+    g_name_chunks->used += len + 1;
+    name_index_insert(g_name_index, g_name_index_capacity, entry);
+    g_name_count++;
+    return entry;
+}
+#endif
+
+static const cdex_descriptor_node_t* find_descriptor_node(uint16_t id) {
+#ifdef CDEX_NO_HEAP
+    for (int i = 0; i < g_descriptor_pool_used; ++i) {
+        if (g_descriptor_pool[i].descriptor.id == id) {
+            return &g_descriptor_pool[i];
         }
-        current = current->next;
     }
+#else
+    if (g_descriptor_index_capacity == 0) return NULL;
+    size_t slot = id_slot(id, g_descriptor_index_capacity);
+    while (g_descriptor_index[slot]) {
+        if (g_descriptor_index[slot]->descriptor.id == id) {
+            return g_descriptor_index[slot];
+        }
+        slot = (slot + 1) & (g_descriptor_index_capacity - 1);
+    }
+#endif
     return NULL;
 }
 
+const cdex_descriptor_t* cdex_get_descriptor_by_id(uint16_t id) {
+    const cdex_descriptor_node_t* node = find_descriptor_node(id);
+    return node ? &node->descriptor : NULL;
+}
+
+cdex_status_t cdex_descriptor_bind_dict(uint16_t id, cdex_dict_t* dict) {
+    cdex_descriptor_node_t* node = (cdex_descriptor_node_t*)find_descriptor_node(id);
+    if (!node) return CDEX_ERROR_DESCRIPTOR_NOT_FOUND;
+    node->dict = dict;
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 按字段大小分类，预先计算字段偏移所需的位图
+ */
+static void build_layout(const cdex_descriptor_t* desc, cdex_layout_t* layout) {
+    memset(layout, 0, sizeof(cdex_layout_t));
+    for (int i = 0; i < desc->field_count; ++i) {
+        uint64_t bit = 1ULL << i;
+        switch (desc->fields[i].size) {
+            case 1: layout->size_masks[0] |= bit; break;
+            case 2: layout->size_masks[1] |= bit; break;
+            case 4: layout->size_masks[2] |= bit; break;
+            case 8: layout->size_masks[3] |= bit; break;
+            default: layout->var_mask |= bit; break;
+        }
+        if (desc->fields[i].type == CDEX_TYPE_DSTR) layout->dict_mask |= bit;
+    }
+}
+
+/**
+ * @brief 分配一个注册表节点，动态注册时为 field_count 个字段预留紧随其后的空间
+ */
+static cdex_descriptor_node_t* alloc_descriptor_node(int field_count) {
+    cdex_descriptor_node_t* node;
+#ifdef CDEX_NO_HEAP
+    (void)field_count;
+    if (g_descriptor_pool_used >= CDEX_MAX_DESCRIPTORS) return NULL;
+    node = &g_descriptor_pool[g_descriptor_pool_used];
+    memset(node, 0, sizeof(cdex_descriptor_node_t));
+#else
+    size_t size = sizeof(cdex_descriptor_node_t) + (size_t)field_count * sizeof(cdex_field_t);
+    node = (cdex_descriptor_node_t*)calloc(1, size);
+    if (!node) return NULL;
+    node->descriptor.fields = (const cdex_field_t*)(node + 1);
+#endif
+    return node;
+}
+
+static cdex_status_t add_descriptor_node(cdex_descriptor_node_t* node) {
+    build_layout(&node->descriptor, &node->layout);
+#ifdef CDEX_NO_HEAP
+    g_descriptor_pool_used++;
+#else
+    if (!index_descriptor_node(node)) {
+        free(node);
+        return CDEX_ERROR_MEMORY_ALLOCATION;
+    }
+#endif
+    return CDEX_SUCCESS;
+}
+
+#ifdef CDEX_NO_HEAP
+cdex_status_t cdex_descriptor_register(uint16_t id, const char* descriptor_string) {
+    (void)id;
+    (void)descriptor_string;
+    return CDEX_ERROR_MEMORY_ALLOCATION;
+}
+
+cdex_status_t cdex_descriptor_load(uint16_t id, const cdex_field_t* fields, int field_count) {
+    (void)id;
+    (void)fields;
+    (void)field_count;
+    return CDEX_ERROR_MEMORY_ALLOCATION;
+}
+#else
+/**
+ * @brief 把描述字符串解析到字段数组，字段名放入共享名称池
+ * @param keep_invalid 为 true 时没有类型的段也占用一个字段位置 (保持字段索引不变)
+ * @return 解析出的字段数，内存不足时返回-1
+ */
+static int parse_descriptor_string(const char* str, cdex_field_t* fields, int max_fields, bool keep_invalid) {
+    int count = 0;
+    const char* cursor = str;
+    while (*cursor && count < max_fields) {
+        const char* comma = strchr(cursor, ',');
+        size_t len = comma ? (size_t)(comma - cursor) : strlen(cursor);
+        if (len > 0) {
+            char segment[128];
+            if (len >= sizeof(segment)) len = sizeof(segment) - 1;
+            memcpy(segment, cursor, len);
+            segment[len] = '\0';
+
+            cdex_field_t* field = &fields[count];
+            memset(field, 0, sizeof(cdex_field_t));
+            char* hyphen = strchr(segment, ':');
+            if (hyphen) {
+                field->name = intern_name(segment, (size_t)(hyphen - segment));
+                parse_field_type(hyphen + 1, field);
+            } else {
+                field->name = intern_name("", 0);
+            }
+            if (!field->name) return -1;
+            if (hyphen || keep_invalid) count++;
+        }
+        if (!comma) break;
+        cursor = comma + 1;
+    }
+    return count;
+}
+
 cdex_status_t cdex_descriptor_register(uint16_t id, const char* descriptor_string) {
+    if (id == CDEX_RESERVED_ID) return CDEX_ERROR_INVALID_DATA;
     if (cdex_get_descriptor_by_id(id) != NULL) {
         return CDEX_ERROR_ID_EXISTS;
     }
-    cdex_descriptor_node_t* new_node = (cdex_descriptor_node_t*)malloc(sizeof(cdex_descriptor_node_t));
+    // 先解析到栈上，再按实际字段数分配记录
+    cdex_field_t fields[CDEX_MAX_FIELDS];
+    int field_count = parse_descriptor_string(descriptor_string, fields, CDEX_MAX_FIELDS, true);
+    if (field_count < 0) return CDEX_ERROR_MEMORY_ALLOCATION;
+
+    cdex_descriptor_node_t* new_node = alloc_descriptor_node(field_count);
     if (!new_node) return CDEX_ERROR_MEMORY_ALLOCATION;
-    memset(new_node, 0, sizeof(cdex_descriptor_node_t));
     new_node->descriptor.id = id;
-    new_node->descriptor.raw_string = strdup(descriptor_string);
-    if (!new_node->descriptor.raw_string) {
-        free(new_node);
-        return CDEX_ERROR_MEMORY_ALLOCATION;
-    }
-    // 解析字符串以填充 fields 数组
-    char* str_copy = strdup(descriptor_string);
-    if (!str_copy) {
-        free(new_node->descriptor.raw_string);
-        free(new_node);
-        return CDEX_ERROR_MEMORY_ALLOCATION;
-    }
-    char* segment = strtok(str_copy, ",");
-    int field_idx = 0;
-    while (segment != NULL && field_idx < CDEX_MAX_FIELDS) {
-        char* hyphen = strrchr(segment, ':');
-        if (hyphen) {
-            *hyphen = '\0'; // 分割名称和类型
-            strncpy(new_node->descriptor.fields[field_idx].name, segment, sizeof(new_node->descriptor.fields[field_idx].name) - 1);
-            new_node->descriptor.fields[field_idx].type = str_to_type(hyphen + 1, &new_node->descriptor.fields[field_idx].size);
-        }
-        field_idx++;
-        segment = strtok(NULL, ",");
-    }
-    new_node->descriptor.field_count = field_idx;
-    free(str_copy);
-    // 将新节点添加到链表头部
-    new_node->next = g_descriptor_list_head;
-    g_descriptor_list_head = new_node;
-    return CDEX_SUCCESS;
+    new_node->descriptor.field_count = field_count;
+    memcpy((cdex_field_t*)new_node->descriptor.fields, fields, field_count * sizeof(cdex_field_t));
+    return add_descriptor_node(new_node);
 }
 
 cdex_status_t cdex_descriptor_load(uint16_t id, const cdex_field_t* fields, int field_count) {
+    if (id == CDEX_RESERVED_ID) return CDEX_ERROR_INVALID_DATA;
     if (cdex_get_descriptor_by_id(id) != NULL) {
         return CDEX_ERROR_ID_EXISTS;
     }
     if (field_count > CDEX_MAX_FIELDS) {
         return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
     }
-    cdex_descriptor_node_t* new_node = (cdex_descriptor_node_t*)malloc(sizeof(cdex_descriptor_node_t));
+    cdex_descriptor_node_t* new_node = alloc_descriptor_node(field_count);
     if (!new_node) return CDEX_ERROR_MEMORY_ALLOCATION;
-    memset(new_node, 0, sizeof(cdex_descriptor_node_t));
     new_node->descriptor.id = id;
     new_node->descriptor.field_count = field_count;
-    new_node->descriptor.raw_string = NULL; // 没有原始字符串
-    memcpy(new_node->descriptor.fields, fields, field_count * sizeof(cdex_field_t));
+    cdex_field_t* copy = (cdex_field_t*)new_node->descriptor.fields;
+    memcpy(copy, fields, field_count * sizeof(cdex_field_t));
+    // 调用者的名称可能在栈上，拷贝到名称池；字节数由类型决定，不信任调用者填写的值
+    for (int i = 0; i < field_count; ++i) {
+        copy[i].size = type_size(fields[i].type);
+        const char* name = fields[i].name ? fields[i].name : "";
+        copy[i].name = intern_name(name, strlen(name));
+        if (!copy[i].name) {
+            free(new_node);
+            return CDEX_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+    return add_descriptor_node(new_node);
+}
+#endif
 
-    // 将新节点添加到链表头部
-    new_node->next = g_descriptor_list_head;
-    g_descriptor_list_head = new_node;
-    return CDEX_SUCCESS;
+cdex_status_t cdex_descriptor_load_static(const cdex_descriptor_t* desc) {
+    if (!desc || (desc->field_count > 0 && !desc->fields) || desc->id == CDEX_RESERVED_ID) {
+        return CDEX_ERROR_INVALID_DATA;
+    }
+    if (cdex_get_descriptor_by_id(desc->id) != NULL) {
+        return CDEX_ERROR_ID_EXISTS;
+    }
+    if (desc->field_count < 0 || desc->field_count > CDEX_MAX_FIELDS) {
+        return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
+    }
+    // 字段表不会被拷贝，字节数与类型不符时无法修正，只能拒绝
+    for (int i = 0; i < desc->field_count; ++i) {
+        if (desc->fields[i].size != type_size(desc->fields[i].type)) return CDEX_ERROR_INVALID_DATA;
+    }
+    cdex_descriptor_node_t* new_node = alloc_descriptor_node(0);
+    if (!new_node) return CDEX_ERROR_MEMORY_ALLOCATION;
+    new_node->descriptor = *desc; // 只拷贝描述符头，字段表仍指向调用者的常量表
+    return add_descriptor_node(new_node);
 }
 
 cdex_status_t cdex_fields_to_string(char *buf, size_t buf_size, const cdex_field_t *fields, int field_count) {
@@ -208,7 +1045,12 @@ cdex_status_t cdex_fields_to_string(char *buf, size_t buf_size, const cdex_field
             return CDEX_ERROR_INVALID_DATA;
         }
 
-        int written = snprintf(buf + offset, buf_size - offset, "%s:%s", fields[i].name, type_str);
+        int written;
+        if (fields[i].type == CDEX_TYPE_S8 || fields[i].type == CDEX_TYPE_S16 || fields[i].type == CDEX_TYPE_S32) {
+            written = snprintf(buf + offset, buf_size - offset, "%s:%s:%g", fields[i].name, type_str, field_scale(&fields[i]));
+        } else {
+            written = snprintf(buf + offset, buf_size - offset, "%s:%s", fields[i].name, type_str);
+        }
         if (written < 0 || (size_t)written >= buf_size - offset) {
             return CDEX_ERROR_BUFFER_TOO_SMALL;
         }
@@ -229,39 +1071,47 @@ cdex_status_t cdex_string_to_fields(const char *str, cdex_field_t *fields, int *
     if (!str || !fields || !field_count || *field_count <= 0) {
         return CDEX_ERROR_INVALID_DATA;
     }
-
-    char *str_copy = strdup(str);
-    if (!str_copy) {
+#ifdef CDEX_NO_HEAP
+    return CDEX_ERROR_MEMORY_ALLOCATION;
+#else
+    // 字段名放在共享名称池中，在 cdex_manager_cleanup 之前有效
+    int count = parse_descriptor_string(str, fields, *field_count, false);
+    if (count < 0) {
         return CDEX_ERROR_MEMORY_ALLOCATION;
     }
-
-    char *segment = strtok(str_copy, ",");
-    int count = 0;
-
-    while (segment != NULL && count < *field_count) {
-        char *hyphen = strrchr(segment, ':');
-        if (hyphen) {
-            *hyphen = '\0'; // 分割名称和类型
-            strncpy(fields[count].name, segment, sizeof(fields[count].name) - 1);
-            fields[count].type = str_to_type(hyphen + 1, &fields[count].size);
-            count++;
-        }
-        segment = strtok(NULL, ",");
-    }
-
-    free(str_copy);
     *field_count = count;
     return CDEX_SUCCESS;
+#endif
 }
 
-static int count_set_bits_before(uint64_t n, int index) {
+static int popcount64(uint64_t n) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(n);
+#else
     int count = 0;
-    for (int i = 0; i < index; i++) {
-        if ((n >> i) & 1) {
-            count++;
-        }
+    while (n) {
+        n &= n - 1;
+        count++;
     }
     return count;
+#endif
+}
+
+static int lowest_set_bit(uint64_t n) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(n);
+#else
+    int index = 0;
+    while (!(n & 1)) {
+        n >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+static int count_set_bits_before(uint64_t n, int index) {
+    return popcount64(n & ((1ULL << index) - 1));
 }
 
 void cdex_packet_init(cdex_packet_t* packet, uint16_t descriptor_id) {
@@ -328,10 +1178,97 @@ cdex_status_t cdex_packet_pop(cdex_packet_t* packet, int field_index) {
     return CDEX_SUCCESS;
 }
 
+cdex_status_t cdex_packet_merge(cdex_packet_t* dest, cdex_packet_t* part, uint64_t expected_mask) {
+    if (!dest || !part) return CDEX_ERROR_INVALID_DATA;
+    // 描述符不同或字段重叠说明 part 属于下一个数据包
+    if (dest->descriptor_id != part->descriptor_id || (dest->bitmap & part->bitmap)) {
+        return CDEX_ERROR_INVALID_DATA;
+    }
+    // 已知完整字段集合时，dest 已完整或 part 超出该集合同样说明 part 属于下一个数据包
+    if (expected_mask && (dest->bitmap == expected_mask || (part->bitmap & ~expected_mask))) {
+        return CDEX_ERROR_INVALID_DATA;
+    }
+
+    uint64_t merged = dest->bitmap | part->bitmap;
+    cdex_value_t values[CDEX_MAX_FIELDS];
+    int count = 0, dest_idx = 0, part_idx = 0;
+    for (int i = 0; i < CDEX_MAX_FIELDS; ++i) {
+        if ((dest->bitmap >> i) & 1) {
+            values[count++] = dest->values[dest_idx++];
+        } else if ((part->bitmap >> i) & 1) {
+            values[count++] = part->values[part_idx++];
+        }
+    }
+    memcpy(dest->values, values, count * sizeof(cdex_value_t));
+    dest->bitmap = merged;
+    dest->borrowed |= part->borrowed;
+    dest->data_count = count;
+
+    // 动态内存的所有权已转移给 dest
+    part->bitmap = 0;
+    part->borrowed = 0;
+    part->data_count = 0;
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief dstr 字段编码后的字节数；同一包中重复出现的新字符串按带内新增估算，结果不会偏小
+ */
+static int dict_string_packed_size(const cdex_dict_t* dict, const char* str) {
+    uint8_t varint_buffer[10];
+    int index = cdex_dict_find(dict, str);
+    if (index >= 0) return encode_varint(varint_buffer, (uint64_t)index + 2);
+    int str_len = (int)strlen(str) + 1;
+    if (dict && dict->auto_add && dict_has_room(dict, str_len - 1)) {
+        return 1 + encode_varint(varint_buffer, (uint64_t)dict->count) + str_len;
+    }
+    return 1 + str_len;
+}
+
+/**
+ * @brief 按字节对齐的字段编码后的字节数，位字段返回0
+ */
+static int field_packed_size(const cdex_field_t* field_desc, const cdex_value_t* value, const cdex_dict_t* dict) {
+    uint8_t varint_buffer[10];
+    switch (field_desc->type) {
+        case CDEX_TYPE_STR:
+            return (int)strlen(value->str) + 1; // +1 for null terminator
+        case CDEX_TYPE_BIN:
+            return value->bin[0] + 1; // +1 for length byte
+        case CDEX_TYPE_NUM:
+            return encode_varint(varint_buffer, zigzag_encode_64(value->i64));
+        case CDEX_TYPE_DSTR:
+            return dict_string_packed_size(dict, value->str);
+        default:
+            return type_bits(field_desc->type) ? 0 : (int)field_desc->size;
+    }
+}
+
+/**
+ * @brief 计算描述符中 mask 所选字段的 Data List 字节数，相邻位字段共享字节
+ * @param bytes 每个字段按字节对齐编码后的字节数 (按描述符字段索引)
+ */
+static int data_list_size(const cdex_descriptor_t* desc, uint64_t mask, const int* bytes) {
+    int total_size = 0;
+    int run_bits = 0;
+    for (int i = 0; i < desc->field_count; ++i) {
+        if (!((mask >> i) & 1)) continue;
+        int bits = type_bits(desc->fields[i].type);
+        if (bits) {
+            run_bits += bits;
+            continue;
+        }
+        total_size += (run_bits + 7) / 8 + bytes[i];
+        run_bits = 0;
+    }
+    return total_size + (run_bits + 7) / 8;
+}
+
 int cdex_packet_calculate_packed_size(const cdex_packet_t* packet) {
     if (!packet) return -1;
-    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(packet->descriptor_id);
-    if (!desc) return -1;
+    const cdex_descriptor_node_t* node = find_descriptor_node(packet->descriptor_id);
+    if (!node) return -1;
+    const cdex_descriptor_t* desc = &node->descriptor;
 
     // 基础开销: ID (2) + Checksum (2)
     int total_size = 4;
@@ -340,40 +1277,23 @@ int cdex_packet_calculate_packed_size(const cdex_packet_t* packet) {
     total_size += (desc->field_count + 7) / 8;
 
     // Data List 开销
+    int bytes[CDEX_MAX_FIELDS];
     int data_idx = 0;
     for (int i = 0; i < desc->field_count; ++i) {
         if ((packet->bitmap >> i) & 1) {
-            const cdex_field_t* field_desc = &desc->fields[i];
-            const cdex_value_t* value = &packet->values[data_idx];
-            uint8_t varint_buffer[10];
-
-            switch (field_desc->type) {
-                case CDEX_TYPE_STR:
-                    total_size += strlen(value->str) + 1; // +1 for null terminator
-                    break;
-                case CDEX_TYPE_BIN:
-                    total_size += value->bin[0] + 1; // +1 for length byte
-                    break;
-                case CDEX_TYPE_NUM:
-                    total_size += encode_varint(varint_buffer, zigzag_encode_64(value->i64));
-                    break;
-                default:
-                    total_size += field_desc->size;
-                    break;
-            }
+            bytes[i] = field_packed_size(&desc->fields[i], &packet->values[data_idx], node->dict);
             data_idx++;
         }
     }
+    total_size += data_list_size(desc, packet->bitmap, bytes);
 
     return total_size;
 }
 
-// --- 核心功能实现 ---
-
-int cdex_pack(const cdex_packet_t* packet, uint8_t* buffer, size_t buffer_size) {
-    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(packet->descriptor_id);
-    if (!desc) return -1;
+// --- 核心功能实现 ---
 
+static int pack_frame(const cdex_descriptor_t* desc, const cdex_packet_t* packet, cdex_dict_t* dict,
+                      uint8_t* buffer, size_t buffer_size) {
     // 计算Bitmap字节长度
     size_t bitmap_bytes = (desc->field_count + 7) / 8;
 
@@ -389,36 +1309,16 @@ int cdex_pack(const cdex_packet_t* packet, uint8_t* buffer, size_t buffer_size)
     memcpy(ptr, &packet->bitmap, bitmap_bytes);
     ptr += bitmap_bytes;
 
-    // 3. 写入Data List
+    // 3. 写入Data List，相邻位字段按位紧凑排列
+    bit_writer_t writer = { ptr, buffer + buffer_size, NULL, 0 };
     int data_idx = 0;
     for (int i = 0; i < desc->field_count; ++i) {
         if ((packet->bitmap >> i) & 1) {
-            const cdex_field_t* field_desc = &desc->fields[i];
-            const cdex_value_t* value = &packet->values[data_idx];
-
-            if (field_desc->type == CDEX_TYPE_STR) {
-                size_t str_len = strlen(value->str) + 1; // +1 for null terminator
-                if (ptr + str_len > buffer + buffer_size) return -1;
-                memcpy(ptr, value->str, str_len);
-                ptr += str_len;
-            } else if (field_desc->type == CDEX_TYPE_BIN) {
-                if (ptr + value->bin[0] + 1 > buffer + buffer_size) return -1;
-                memcpy(ptr, value->bin, value->bin[0] + 1);
-                ptr += value->bin[0] + 1;
-            } else if (field_desc->type == CDEX_TYPE_NUM) {
-                uint8_t varint_buffer[10];
-                int varint_size = encode_varint(varint_buffer, zigzag_encode_64(value->i64));
-                if (ptr + varint_size > buffer + buffer_size) return -1;
-                memcpy(ptr, varint_buffer, varint_size);
-                ptr += varint_size;
-            } else {
-                if (ptr + field_desc->size > buffer + buffer_size) return -1;
-                memcpy(ptr, value, field_desc->size);
-                ptr += field_desc->size;
-            }
+            if (!encode_field(&writer, &desc->fields[i], &packet->values[data_idx], dict)) return -1;
             data_idx++;
         }
     }
+    ptr = writer.ptr;
 
     // 4. 计算并写入Checksum
     size_t data_len = ptr - buffer;
@@ -430,8 +1330,133 @@ int cdex_pack(const cdex_packet_t* packet, uint8_t* buffer, size_t buffer_size)
     return ptr - buffer;
 }
 
+/**
+ * @brief 打包并在失败时撤销本次自动加入字典的条目，避免收发双方字典不同步
+ */
+static void dict_rollback(cdex_dict_t* dict, int saved_count, size_t saved_pool_used) {
+    if (!dict) return;
+    for (int i = saved_count; i < dict->count; ++i) {
+        dict->offsets[i] = DICT_EMPTY;
+    }
+    dict->count = saved_count;
+    dict->pool_used = saved_pool_used;
+}
+
+static int pack_with_dict_rollback(const cdex_descriptor_t* desc, const cdex_packet_t* packet, cdex_dict_t* dict,
+                                   uint8_t* buffer, size_t buffer_size) {
+    int saved_count = dict ? dict->count : 0;
+    size_t saved_pool_used = dict ? dict->pool_used : 0;
+    int packed = pack_frame(desc, packet, dict, buffer, buffer_size);
+    if (packed < 0) {
+        dict_rollback(dict, saved_count, saved_pool_used);
+    }
+    return packed;
+}
 
-cdex_status_t cdex_parse(const uint8_t* buffer, size_t buffer_len, cdex_packet_t* packet_out) {
+int cdex_pack(const cdex_packet_t* packet, uint8_t* buffer, size_t buffer_size) {
+    const cdex_descriptor_node_t* node = find_descriptor_node(packet->descriptor_id);
+    if (!node) return -1;
+    return pack_with_dict_rollback(&node->descriptor, packet, node->dict, buffer, buffer_size);
+}
+
+int cdex_pack_with_dict(const cdex_packet_t* packet, cdex_dict_t* dict, uint8_t* buffer, size_t buffer_size) {
+    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(packet->descriptor_id);
+    if (!desc) return -1;
+    return pack_with_dict_rollback(desc, packet, dict, buffer, buffer_size);
+}
+
+int cdex_pack_mtu(const cdex_packet_t* packet, size_t mtu, uint8_t* buffer, size_t buffer_size,
+                  int* frame_lens, int max_frames) {
+    if (!packet || !buffer || !frame_lens || max_frames <= 0) return -1;
+    const cdex_descriptor_node_t* node = find_descriptor_node(packet->descriptor_id);
+    if (!node) return -1;
+    const cdex_descriptor_t* desc = &node->descriptor;
+
+    int overhead = 4 + (desc->field_count + 7) / 8; // ID + Bitmap + CRC
+    if (mtu <= (size_t)overhead) return -1;
+    int capacity = mtu - overhead > INT32_MAX ? INT32_MAX : (int)(mtu - overhead);
+
+    // 按占用位数从大到小排序后首次适配 (FFD)，用精确的子集大小判断能否放入
+    int bytes[CDEX_MAX_FIELDS];
+    int order[CDEX_MAX_FIELDS];
+    int cost[CDEX_MAX_FIELDS];
+    int value_index[CDEX_MAX_FIELDS];
+    int field_total = 0;
+    int data_idx = 0;
+    for (int i = 0; i < desc->field_count; ++i) {
+        if (!((packet->bitmap >> i) & 1)) continue;
+        bytes[i] = field_packed_size(&desc->fields[i], &packet->values[data_idx], node->dict);
+        value_index[i] = data_idx++;
+        int bits = type_bits(desc->fields[i].type);
+        cost[i] = bits ? bits : bytes[i] * 8;
+        // 插入排序，字段数不超过 64
+        int pos = field_total++;
+        while (pos > 0 && cost[order[pos - 1]] < cost[i]) {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+    }
+
+    uint64_t frame_masks[CDEX_MAX_FIELDS];
+    int frame_count = 0;
+    for (int k = 0; k < field_total; ++k) {
+        int field = order[k];
+        uint64_t bit = 1ULL << field;
+        int target = -1;
+        for (int f = 0; f < frame_count; ++f) {
+            if (data_list_size(desc, frame_masks[f] | bit, bytes) <= capacity) {
+                target = f;
+                break;
+            }
+        }
+        if (target < 0) {
+            if (data_list_size(desc, bit, bytes) > capacity) return -1; // 单个字段已超过 MTU
+            target = frame_count++;
+            frame_masks[target] = 0;
+        }
+        frame_masks[target] |= bit;
+    }
+    if (frame_count == 0) {
+        frame_masks[0] = 0; // 空数据包也输出一帧
+        frame_count = 1;
+    }
+    if (frame_count > max_frames) return -1;
+
+    // 按字段顺序依次打包，任一帧失败时撤销整个调用自动加入字典的条目
+    cdex_dict_t* dict = node->dict;
+    int saved_count = dict ? dict->count : 0;
+    size_t saved_pool_used = dict ? dict->pool_used : 0;
+    size_t offset = 0;
+    for (int f = 0; f < frame_count; ++f) {
+        cdex_packet_t part;
+        cdex_packet_init(&part, packet->descriptor_id);
+        part.bitmap = frame_masks[f];
+        for (int i = 0; i < desc->field_count; ++i) {
+            if ((frame_masks[f] >> i) & 1) {
+                part.values[part.data_count++] = packet->values[value_index[i]];
+            }
+        }
+        size_t room = buffer_size - offset < mtu ? buffer_size - offset : mtu;
+        int packed = pack_frame(desc, &part, dict, buffer + offset, room);
+        if (packed < 0) {
+            dict_rollback(dict, saved_count, saved_pool_used);
+            return -1;
+        }
+        frame_lens[f] = packed;
+        offset += packed;
+    }
+    return frame_count;
+}
+
+
+/**
+ * @param use_bound_dict 为 true 时使用描述符绑定的字典，否则使用 dict
+ */
+static cdex_status_t parse_frame(const uint8_t* buffer, size_t buffer_len, bool use_bound_dict, cdex_dict_t* dict,
+                                 cdex_packet_t* packet_out) {
+    // 先清零，任何失败路径之后调用者都可以安全地调用 cdex_free_packet_memory
+    memset(packet_out, 0, sizeof(cdex_packet_t));
     if (buffer_len < 5) return CDEX_ERROR_INVALID_PACKET; // 至少 ID(2) + Bitmap(1) + CRC(2)
 
     // 1. 校验Checksum
@@ -439,15 +1464,16 @@ cdex_status_t cdex_parse(const uint8_t* buffer, size_t buffer_len, cdex_packet_t
     uint16_t calculated_crc = calculate_crc16(buffer, buffer_len - 2);
     if (received_crc != calculated_crc) return CDEX_ERROR_BAD_CHECKSUM;
 
-    memset(packet_out, 0, sizeof(cdex_packet_t));
     const uint8_t* ptr = buffer;
 
     // 2. 解析Descriptor ID
     packet_out->descriptor_id = *(uint16_t*)ptr;
     ptr += 2;
 
-    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(packet_out->descriptor_id);
-    if (!desc) return CDEX_ERROR_DESCRIPTOR_NOT_FOUND;
+    const cdex_descriptor_node_t* node = find_descriptor_node(packet_out->descriptor_id);
+    if (!node) return CDEX_ERROR_DESCRIPTOR_NOT_FOUND;
+    const cdex_descriptor_t* desc = &node->descriptor;
+    if (use_bound_dict) dict = node->dict;
 
     // 3. 解析Bitmap
     size_t bitmap_bytes = (desc->field_count + 7) / 8;
@@ -456,44 +1482,15 @@ cdex_status_t cdex_parse(const uint8_t* buffer, size_t buffer_len, cdex_packet_t
     ptr += bitmap_bytes;
 
     // 4. 解析Data List
+    bit_reader_t reader = { ptr, buffer + buffer_len - 2, NULL, 0 };
     int data_idx = 0;
     for (int i = 0; i < desc->field_count; ++i) {
         if ((packet_out->bitmap >> i) & 1) {
-            const cdex_field_t* field_desc = &desc->fields[i];
-            cdex_value_t* value_out = &packet_out->values[data_idx];
-
-            if (field_desc->type == CDEX_TYPE_STR) {
-                const char* str_start = (const char*)ptr;
-                size_t max_len = (buffer + buffer_len - 2) - ptr;
-                size_t str_len = strnlen(str_start, max_len);
-
-                if (str_len == max_len) return CDEX_ERROR_INVALID_DATA; // No null terminator found
-
-                value_out->str = (char*)malloc(str_len + 1);
-                if (!value_out->str) return CDEX_ERROR_MEMORY_ALLOCATION;
-                memcpy(value_out->str, str_start, str_len + 1);
-                ptr += str_len + 1;
-            } else if (field_desc->type == CDEX_TYPE_BIN) {
-                if (ptr + 1 > buffer + buffer_len - 2) return CDEX_ERROR_BUFFER_TOO_SMALL;
-                size_t bin_len = ptr[0];
-                if (ptr + 1 + bin_len > buffer + buffer_len - 2) return CDEX_ERROR_BUFFER_TOO_SMALL;
-
-                value_out->bin = (uint8_t*)malloc(bin_len + 1);
-                if (!value_out->bin) return CDEX_ERROR_MEMORY_ALLOCATION;
-                memcpy(value_out->bin, ptr, bin_len + 1);
-                ptr += bin_len + 1;
-            } else if (field_desc->type == CDEX_TYPE_NUM) {
-                int varint_size = 0;
-                uint64_t decoded = decode_varint(ptr, &varint_size);
-                if (ptr + varint_size > buffer + buffer_len - 2) return CDEX_ERROR_BUFFER_TOO_SMALL;
-
-                value_out->i64 = zigzag_decode_64(decoded);
-                ptr += varint_size;
-            } else {
-                if (ptr + field_desc->size > buffer + buffer_len - 2) return CDEX_ERROR_BUFFER_TOO_SMALL;
-                memcpy(value_out, ptr, field_desc->size);
-                ptr += field_desc->size;
-            }
+            bool borrowed;
+            cdex_status_t status = decode_field(&reader, &desc->fields[i], &packet_out->values[data_idx], true,
+                                                dict, &borrowed);
+            if (borrowed) packet_out->borrowed |= 1ULL << i;
+            if (status != CDEX_SUCCESS) return status;
             data_idx++;
         }
     }
@@ -502,6 +1499,14 @@ cdex_status_t cdex_parse(const uint8_t* buffer, size_t buffer_len, cdex_packet_t
     return CDEX_SUCCESS;
 }
 
+cdex_status_t cdex_parse(const uint8_t* buffer, size_t buffer_len, cdex_packet_t* packet_out) {
+    return parse_frame(buffer, buffer_len, true, NULL, packet_out);
+}
+
+cdex_status_t cdex_parse_with_dict(const uint8_t* buffer, size_t buffer_len, cdex_dict_t* dict, cdex_packet_t* packet_out) {
+    return parse_frame(buffer, buffer_len, false, dict, packet_out);
+}
+
 #ifdef CDEX_PARSE_TO_JSON
 cJSON* cdex_packet_to_json(const cdex_packet_t* packet) {
     const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(packet->descriptor_id);
@@ -531,7 +1536,15 @@ cJSON* cdex_packet_to_json(const cdex_packet_t* packet) {
                 case CDEX_TYPE_NUM: cJSON_AddNumberToObject(root, field_desc->name, (double)value->i64); break;
                 case CDEX_TYPE_F32: cJSON_AddNumberToObject(root, field_desc->name, value->f32); break;
                 case CDEX_TYPE_D64: cJSON_AddNumberToObject(root, field_desc->name, value->d64); break;
-                case CDEX_TYPE_STR: cJSON_AddStringToObject(root, field_desc->name, value->str); break;
+                case CDEX_TYPE_STR:
+                case CDEX_TYPE_DSTR: cJSON_AddStringToObject(root, field_desc->name, value->str); break;
+                case CDEX_TYPE_U1: case CDEX_TYPE_U2: case CDEX_TYPE_U3: case CDEX_TYPE_U4:
+                case CDEX_TYPE_U5: case CDEX_TYPE_U6: case CDEX_TYPE_U7:
+                    cJSON_AddNumberToObject(root, field_desc->name, value->u8); break;
+                case CDEX_TYPE_B1: cJSON_AddBoolToObject(root, field_desc->name, value->u8 != 0); break;
+                case CDEX_TYPE_F16: cJSON_AddNumberToObject(root, field_desc->name, value->f32); break;
+                case CDEX_TYPE_S8: case CDEX_TYPE_S16: case CDEX_TYPE_S32:
+                    cJSON_AddNumberToObject(root, field_desc->name, value->d64); break;
                 case CDEX_TYPE_BIN: {
                     cJSON* bin_array = cJSON_CreateArray();
                     for (size_t j = 1; j <= value->bin[0]; ++j) { // value->bin[0] is length
@@ -550,13 +1563,21 @@ cJSON* cdex_packet_to_json(const cdex_packet_t* packet) {
 #endif
 
 void cdex_free_packet_memory(cdex_packet_t* packet) {
+#ifdef CDEX_NO_HEAP
+    // 解析结果全部指向输入缓冲区或字典，没有需要释放的内存
+    (void)packet;
+#else
     const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(packet->descriptor_id);
     if (!desc) return;
 
     int data_idx = 0;
     for (int i = 0; i < desc->field_count; ++i) {
         if ((packet->bitmap >> i) & 1) {
-            if (desc->fields[i].type == CDEX_TYPE_STR) {
+            if ((packet->borrowed >> i) & 1) {
+                data_idx++;
+                continue;
+            }
+            if (desc->fields[i].type == CDEX_TYPE_STR || desc->fields[i].type == CDEX_TYPE_DSTR) {
                 if (packet->values[data_idx].str) {
                     free(packet->values[data_idx].str);
                     packet->values[data_idx].str = NULL;
@@ -571,4 +1592,698 @@ void cdex_free_packet_memory(cdex_packet_t* packet) {
             data_idx++;
         }
     }
+#endif
+}
+
+// --- 字节流遍历 ---
+
+/**
+ * @brief 解析帧头，可选校验 CRC
+ * @param verify_crc 为 false 时跳过校验，用于随后仍会经过 cdex_parse 的快速路径
+ * @param payload [out] 指向 Payload 起始位置
+ * @param payload_end [out] 指向 Checksum 起始位置
+ */
+static cdex_status_t read_frame_header(const uint8_t* buffer, size_t buffer_len, bool verify_crc,
+                                       const cdex_descriptor_t** desc_out, uint64_t* bitmap_out,
+                                       const uint8_t** payload, const uint8_t** payload_end) {
+    if (!buffer || buffer_len < 5) return CDEX_ERROR_INVALID_PACKET;
+
+    if (verify_crc) {
+        uint16_t received_crc = *(uint16_t*)(buffer + buffer_len - 2);
+        if (received_crc != calculate_crc16(buffer, buffer_len - 2)) return CDEX_ERROR_BAD_CHECKSUM;
+    }
+
+    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(*(uint16_t*)buffer);
+    if (!desc) return CDEX_ERROR_DESCRIPTOR_NOT_FOUND;
+
+    size_t bitmap_bytes = (desc->field_count + 7) / 8;
+    if (2 + bitmap_bytes > buffer_len - 2) return CDEX_ERROR_INVALID_PACKET;
+    uint64_t bitmap = 0;
+    memcpy(&bitmap, buffer + 2, bitmap_bytes);
+
+    *desc_out = desc;
+    *bitmap_out = bitmap;
+    *payload = buffer + 2 + bitmap_bytes;
+    *payload_end = buffer + buffer_len - 2;
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 遍历 Payload，记录每个存在字段相对 payload 的起始位偏移 (按描述符字段索引存放)
+ */
+static cdex_status_t scan_fields(const cdex_descriptor_t* desc, uint64_t bitmap, const uint8_t* payload,
+                                 const uint8_t* end, uint32_t* bit_offsets) {
+    bit_reader_t reader = { payload, end, NULL, 0 };
+    for (int i = 0; i < desc->field_count; ++i) {
+        if ((bitmap >> i) & 1) {
+            bit_offsets[i] = reader_bit_offset(&reader, payload, type_bits(desc->fields[i].type) == 0);
+            if (!skip_field(&reader, &desc->fields[i])) return CDEX_ERROR_INVALID_DATA;
+        }
+    }
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 写入帧头 (ID + Bitmap)
+ * @return 写入的字节数，失败返回-1
+ */
+static int write_frame_header(uint8_t* buffer, size_t buffer_size, uint16_t id, uint64_t bitmap, int field_count) {
+    size_t bitmap_bytes = (field_count + 7) / 8;
+    if (2 + bitmap_bytes > buffer_size) return -1;
+    *(uint16_t*)buffer = id;
+    memcpy(buffer + 2, &bitmap, bitmap_bytes);
+    return (int)(2 + bitmap_bytes);
+}
+
+/**
+ * @brief 在已写入的帧末尾追加 Checksum
+ * @return 完整帧的字节数，失败返回-1
+ */
+static int write_frame_checksum(uint8_t* buffer, size_t data_len, size_t buffer_size) {
+    if (data_len + 2 > buffer_size) return -1;
+    uint16_t crc = calculate_crc16(buffer, data_len);
+    *(uint16_t*)(buffer + data_len) = crc;
+    return (int)(data_len + 2);
+}
+
+// --- 描述符版本转码 ---
+
+/**
+ * @brief 版本转码表：from 描述符字段索引到 to 描述符字段索引的映射
+ */
+typedef struct cdex_transcoder_node {
+    uint16_t from_id;
+    uint16_t to_id;
+    uint64_t keep_mask;                 // from 中在 to 里有对应字段的位
+    int8_t source_of[CDEX_MAX_FIELDS];  // to 字段索引 -> from 字段索引，-1 表示无对应
+    int8_t target_of[CDEX_MAX_FIELDS];  // from 字段索引 -> to 字段索引，-1 表示无对应，用于重映射 DataMask
+    struct cdex_transcoder_node* next;
+} cdex_transcoder_node_t;
+
+static cdex_transcoder_node_t* g_transcoder_list_head = NULL;
+
+#ifdef CDEX_NO_HEAP
+static cdex_transcoder_node_t g_transcoder_pool[CDEX_MAX_TRANSCODERS];
+static int g_transcoder_pool_used = 0;
+#endif
+
+static const cdex_transcoder_node_t* find_transcoder(uint16_t from_id, uint16_t to_id) {
+    for (cdex_transcoder_node_t* node = g_transcoder_list_head; node != NULL; node = node->next) {
+        if (node->from_id == from_id && node->to_id == to_id) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+static void transcoders_cleanup(void) {
+#ifdef CDEX_NO_HEAP
+    g_transcoder_pool_used = 0;
+#else
+    cdex_transcoder_node_t* current = g_transcoder_list_head;
+    while (current != NULL) {
+        cdex_transcoder_node_t* next = current->next;
+        free(current);
+        current = next;
+    }
+#endif
+    g_transcoder_list_head = NULL;
+}
+
+static cdex_transcoder_node_t* build_transcoder(const cdex_descriptor_t* from, const cdex_descriptor_t* to) {
+#ifdef CDEX_NO_HEAP
+    if (g_transcoder_pool_used >= CDEX_MAX_TRANSCODERS) return NULL;
+    cdex_transcoder_node_t* node = &g_transcoder_pool[g_transcoder_pool_used++];
+#else
+    cdex_transcoder_node_t* node = (cdex_transcoder_node_t*)malloc(sizeof(cdex_transcoder_node_t));
+    if (!node) return NULL;
+#endif
+    memset(node, 0, sizeof(cdex_transcoder_node_t));
+    node->from_id = from->id;
+    node->to_id = to->id;
+    memset(node->target_of, -1, sizeof(node->target_of));
+    // 按名称和类型匹配字段，类型或缩放系数不同的同名字段视为不兼容
+    for (int j = 0; j < to->field_count; ++j) {
+        node->source_of[j] = -1;
+        for (int i = 0; i < from->field_count; ++i) {
+            if (from->fields[i].type == to->fields[j].type && from->fields[i].scale == to->fields[j].scale &&
+                strcmp(from->fields[i].name, to->fields[j].name) == 0) {
+                node->source_of[j] = (int8_t)i;
+                if (node->target_of[i] < 0) node->target_of[i] = (int8_t)j;
+                node->keep_mask |= 1ULL << i;
+                break;
+            }
+        }
+    }
+    return node;
+}
+
+cdex_status_t cdex_descriptor_link_version(uint16_t old_id, uint16_t new_id) {
+    const cdex_descriptor_t* old_desc = cdex_get_descriptor_by_id(old_id);
+    const cdex_descriptor_t* new_desc = cdex_get_descriptor_by_id(new_id);
+    if (!old_desc || !new_desc) return CDEX_ERROR_DESCRIPTOR_NOT_FOUND;
+    if (old_id == new_id) return CDEX_ERROR_INVALID_DATA;
+    if (find_transcoder(old_id, new_id)) return CDEX_ERROR_ID_EXISTS;
+
+    cdex_transcoder_node_t* forward = build_transcoder(old_desc, new_desc);
+    if (!forward) return CDEX_ERROR_MEMORY_ALLOCATION;
+    cdex_transcoder_node_t* backward = build_transcoder(new_desc, old_desc);
+    if (!backward) {
+#ifdef CDEX_NO_HEAP
+        g_transcoder_pool_used--; // forward 是最后分配的一项
+#else
+        free(forward);
+#endif
+        return CDEX_ERROR_MEMORY_ALLOCATION;
+    }
+    forward->next = backward;
+    backward->next = g_transcoder_list_head;
+    g_transcoder_list_head = forward;
+    return CDEX_SUCCESS;
+}
+
+int cdex_transcode(const uint8_t* buffer, size_t buffer_len, uint16_t target_id, uint8_t* out, size_t out_size) {
+    const cdex_descriptor_t* from;
+    uint64_t bitmap;
+    const uint8_t* payload;
+    const uint8_t* payload_end;
+    if (read_frame_header(buffer, buffer_len, true, &from, &bitmap, &payload, &payload_end) != CDEX_SUCCESS) return -1;
+
+    const cdex_transcoder_node_t* tc = find_transcoder(from->id, target_id);
+    const cdex_descriptor_node_t* to_node = find_descriptor_node(target_id);
+    if (!tc || !to_node) return -1;
+    const cdex_descriptor_t* to = &to_node->descriptor;
+    cdex_dict_t* from_dict = find_descriptor_node(from->id)->dict;
+
+    uint32_t bit_offsets[CDEX_MAX_FIELDS];
+    if (scan_fields(from, bitmap, payload, payload_end, bit_offsets) != CDEX_SUCCESS) return -1;
+
+    // Bitmap 重映射，只遍历源帧中存在且有对应字段的位
+    uint64_t new_bitmap = 0;
+    for (uint64_t kept = bitmap & tc->keep_mask; kept; kept &= kept - 1) {
+        new_bitmap |= 1ULL << tc->target_of[lowest_set_bit(kept)];
+    }
+
+    int written = write_frame_header(out, out_size, target_id, new_bitmap, to->field_count);
+    if (written < 0) return -1;
+    bit_writer_t writer = { out + written, out + out_size, NULL, 0 };
+
+    // 按新描述符的字段顺序直接拷贝字段字节
+    for (int j = 0; j < to->field_count; ++j) {
+        if ((new_bitmap >> j) & 1) {
+            bit_reader_t reader;
+            reader_seek(&reader, payload, payload_end, bit_offsets[tc->source_of[j]]);
+            if (to->fields[j].type == CDEX_TYPE_DSTR && from_dict != to_node->dict) {
+                // 两个版本绑定的字典不同，索引不能原样拷贝，改写为字面量
+                cdex_value_t value;
+                bool borrowed;
+                if (decode_field(&reader, &from->fields[tc->source_of[j]], &value, false, from_dict,
+                                 &borrowed) != CDEX_SUCCESS ||
+                    !encode_field(&writer, &to->fields[j], &value, NULL)) {
+                    return -1;
+                }
+            } else if (!copy_field(&reader, &writer, &to->fields[j])) {
+                return -1;
+            }
+        }
+    }
+
+    return write_frame_checksum(out, writer.ptr - out, out_size);
+}
+
+// --- 字段投影 ---
+
+/**
+ * @brief 字段投影，带有新增字典条目的 dstr 字段即使不在 keep_mask 中也会保留
+ * @param kept_out [out] 输出帧实际保留的字段位图
+ */
+static int project_frame(const uint8_t* buffer, size_t buffer_len, uint64_t keep_mask, uint8_t* out, size_t out_size,
+                         uint64_t* kept_out) {
+    const cdex_descriptor_t* desc;
+    uint64_t bitmap;
+    const uint8_t* payload;
+    const uint8_t* payload_end;
+    if (read_frame_header(buffer, buffer_len, true, &desc, &bitmap, &payload, &payload_end) != CDEX_SUCCESS) return -1;
+    const cdex_layout_t* layout = &find_descriptor_node(desc->id)->layout;
+
+    // 保留的字段在遍历后才确定，帧头最后写入
+    size_t header_len = 2 + (desc->field_count + 7) / 8;
+    if (header_len > out_size) return -1;
+    bit_reader_t reader = { payload, payload_end, NULL, 0 };
+    bit_writer_t writer = { out + header_len, out + out_size, NULL, 0 };
+
+    uint64_t kept = 0;
+    for (int i = 0; i < desc->field_count; ++i) {
+        if (!((bitmap >> i) & 1)) continue;
+        bool keep = (keep_mask >> i) & 1;
+        if (!keep && ((layout->dict_mask >> i) & 1)) {
+            // 丢掉带内新增的条目会让接收端字典失步，dstr 字段按字节对齐，ptr 即字段起始位置
+            keep = is_dict_add(reader.ptr, reader.end);
+        }
+        bool ok = keep ? copy_field(&reader, &writer, &desc->fields[i]) : skip_field(&reader, &desc->fields[i]);
+        if (!ok) return -1;
+        if (keep) kept |= 1ULL << i;
+    }
+
+    write_frame_header(out, out_size, desc->id, kept, desc->field_count);
+    if (kept_out) *kept_out = kept;
+    return write_frame_checksum(out, writer.ptr - out, out_size);
+}
+
+int cdex_project(const uint8_t* buffer, size_t buffer_len, uint64_t keep_mask, uint8_t* out, size_t out_size) {
+    return project_frame(buffer, buffer_len, keep_mask, out, out_size, NULL);
+}
+
+void cdex_route_table_init(cdex_route_table_t* table) {
+    if (!table) return;
+    memset(table, 0, sizeof(cdex_route_table_t));
+}
+
+cdex_status_t cdex_route_table_set(cdex_route_table_t* table, uint16_t descriptor_id, uint64_t keep_mask) {
+    if (!table) return CDEX_ERROR_INVALID_DATA;
+    for (int i = 0; i < table->route_count; ++i) {
+        if (table->routes[i].descriptor_id == descriptor_id) {
+            table->routes[i].keep_mask = keep_mask;
+            return CDEX_SUCCESS;
+        }
+    }
+    if (table->route_count >= CDEX_MAX_ROUTES) return CDEX_ERROR_QUEUE_FULL;
+    table->routes[table->route_count].descriptor_id = descriptor_id;
+    table->routes[table->route_count].keep_mask = keep_mask;
+    table->route_count++;
+    return CDEX_SUCCESS;
+}
+
+int cdex_project_routed(const cdex_route_table_t* table, const uint8_t* buffer, size_t buffer_len,
+                        uint8_t* out, size_t out_size) {
+    if (!table || !buffer || buffer_len < 5) return -1;
+
+    // 在校验 CRC 之前按ID查表，不需要的包尽早丢弃
+    uint16_t id = *(uint16_t*)buffer;
+    uint64_t keep_mask = 0;
+    for (int i = 0; i < table->route_count; ++i) {
+        if (table->routes[i].descriptor_id == id) {
+            keep_mask = table->routes[i].keep_mask;
+            break;
+        }
+    }
+    if (keep_mask == 0) return 0;
+
+    const cdex_descriptor_node_t* node = find_descriptor_node(id);
+    if (!node) return -1;
+    size_t bitmap_bytes = (node->descriptor.field_count + 7) / 8;
+    if (2 + bitmap_bytes > buffer_len - 2) return -1;
+    uint64_t bitmap = 0;
+    memcpy(&bitmap, buffer + 2, bitmap_bytes);
+    // 含 dstr 字段的帧可能带有新增字典条目，需要检查后才能丢弃
+    if ((bitmap & keep_mask) == 0 && (bitmap & node->layout.dict_mask) == 0) return 0;
+
+    uint64_t kept;
+    int written = project_frame(buffer, buffer_len, keep_mask, out, out_size, &kept);
+    return written > 0 && kept == 0 ? 0 : written;
+}
+
+// --- 随机访问读取器 ---
+
+/**
+ * @brief 只由定长字段决定的偏移：按大小分类分别计数
+ */
+static size_t fixed_prefix_offset(const cdex_layout_t* layout, uint64_t present_below) {
+    return popcount64(present_below & layout->size_masks[0]) +
+           2 * popcount64(present_below & layout->size_masks[1]) +
+           4 * popcount64(present_below & layout->size_masks[2]) +
+           8 * popcount64(present_below & layout->size_masks[3]);
+}
+
+/**
+ * @brief 定位字段值，返回指向字段起始位置的读取游标
+ */
+static cdex_status_t reader_locate(cdex_reader_t* reader, int field_index, bit_reader_t* cursor) {
+    if (field_index < 0 || field_index >= reader->desc->field_count) return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
+    if (!((reader->bitmap >> field_index) & 1)) return CDEX_ERROR_FIELD_NOT_PRESENT;
+
+    uint64_t present_below = reader->bitmap & ((1ULL << field_index) - 1);
+    if ((present_below & reader->layout->var_mask) == 0) {
+        uint32_t offset = (uint32_t)fixed_prefix_offset(reader->layout, present_below) * 8;
+        reader_seek(cursor, reader->payload, reader->payload_end, offset);
+        return CDEX_SUCCESS;
+    }
+
+    if (reader->indexed_count == 0) {
+        // 从第一个存在的变长字段或位字段开始建立索引，它之前的偏移可直接计算
+        uint64_t present_var = reader->bitmap & reader->layout->var_mask;
+        int first_var = 0;
+        while (!((present_var >> first_var) & 1)) first_var++;
+        uint64_t before_var = reader->bitmap & ((1ULL << first_var) - 1);
+        reader->index_bit_offset = (uint32_t)fixed_prefix_offset(reader->layout, before_var) * 8;
+        reader->indexed_count = first_var;
+    }
+    if (reader->indexed_count <= field_index) {
+        bit_reader_t walk;
+        reader_seek(&walk, reader->payload, reader->payload_end, reader->index_bit_offset);
+        while (reader->indexed_count <= field_index) {
+            int i = reader->indexed_count;
+            if ((reader->bitmap >> i) & 1) {
+                const cdex_field_t* field_desc = &reader->desc->fields[i];
+                reader->offsets[i] = reader_bit_offset(&walk, reader->payload, type_bits(field_desc->type) == 0);
+                if (!skip_field(&walk, field_desc)) return CDEX_ERROR_INVALID_DATA;
+            }
+            reader->indexed_count++;
+        }
+        reader->index_bit_offset = reader_bit_offset(&walk, reader->payload, false);
+    }
+    reader_seek(cursor, reader->payload, reader->payload_end, reader->offsets[field_index]);
+    return CDEX_SUCCESS;
+}
+
+static cdex_status_t reader_setup(cdex_reader_t* reader, const uint8_t* buffer, size_t buffer_len, bool verify_crc) {
+    memset(reader, 0, sizeof(cdex_reader_t));
+    cdex_status_t status = read_frame_header(buffer, buffer_len, verify_crc, &reader->desc, &reader->bitmap,
+                                             &reader->payload, &reader->payload_end);
+    if (status != CDEX_SUCCESS) return status;
+    const cdex_descriptor_node_t* node = find_descriptor_node(reader->desc->id);
+    reader->layout = &node->layout;
+    reader->dict = node->dict;
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 帧中是否有 dstr 字段带有新增字典条目
+ */
+static bool reader_carries_dict_add(cdex_reader_t* reader) {
+    uint64_t fields = reader->bitmap & reader->layout->dict_mask;
+    for (int i = 0; fields; ++i, fields >>= 1) {
+        if (!(fields & 1)) continue;
+        bit_reader_t cursor;
+        if (reader_locate(reader, i, &cursor) == CDEX_SUCCESS && is_dict_add(cursor.ptr, cursor.end)) return true;
+    }
+    return false;
+}
+
+cdex_status_t cdex_reader_init(cdex_reader_t* reader, const uint8_t* buffer, size_t buffer_len) {
+    if (!reader) return CDEX_ERROR_INVALID_DATA;
+    return reader_setup(reader, buffer, buffer_len, true);
+}
+
+bool cdex_reader_has(const cdex_reader_t* reader, int field_index) {
+    if (!reader || !reader->desc || field_index < 0 || field_index >= reader->desc->field_count) return false;
+    return (reader->bitmap >> field_index) & 1;
+}
+
+cdex_status_t cdex_reader_get(cdex_reader_t* reader, int field_index, cdex_value_t* value) {
+    if (!reader || !reader->desc || !value) return CDEX_ERROR_INVALID_DATA;
+    bit_reader_t cursor;
+    cdex_status_t status = reader_locate(reader, field_index, &cursor);
+    if (status != CDEX_SUCCESS) return status;
+
+    memset(value, 0, sizeof(cdex_value_t));
+    bool borrowed;
+    return decode_field(&cursor, &reader->desc->fields[field_index], value, false, reader->dict, &borrowed);
+}
+
+cdex_status_t cdex_reader_get_str(cdex_reader_t* reader, int field_index, const char** str) {
+    if (!reader || !reader->desc || !str) return CDEX_ERROR_INVALID_DATA;
+    if (field_index < 0 || field_index >= reader->desc->field_count) return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
+    cdex_data_type_t type = reader->desc->fields[field_index].type;
+    if (type != CDEX_TYPE_STR && type != CDEX_TYPE_DSTR) return CDEX_ERROR_INVALID_DATA;
+    cdex_value_t value;
+    cdex_status_t status = cdex_reader_get(reader, field_index, &value);
+    if (status != CDEX_SUCCESS) return status;
+    *str = value.str;
+    return CDEX_SUCCESS;
+}
+
+cdex_status_t cdex_reader_get_bin(cdex_reader_t* reader, int field_index, const uint8_t** data, size_t* len) {
+    if (!reader || !reader->desc || !data || !len) return CDEX_ERROR_INVALID_DATA;
+    if (field_index < 0 || field_index >= reader->desc->field_count) return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
+    if (reader->desc->fields[field_index].type != CDEX_TYPE_BIN) return CDEX_ERROR_INVALID_DATA;
+    cdex_value_t value;
+    cdex_status_t status = cdex_reader_get(reader, field_index, &value);
+    if (status != CDEX_SUCCESS) return status;
+    *data = value.bin + 1;
+    *len = value.bin[0];
+    return CDEX_SUCCESS;
+}
+
+// --- 过滤器 ---
+
+#define FILTER_OP_AND (-1)
+#define FILTER_OP_OR (-2)
+#define FILTER_OP_NOT (-3)
+#define FILTER_MAX_DEPTH CDEX_FILTER_MAX_OPS // ! 和括号的最大嵌套层数，更深的表达式也放不进程序
+
+typedef struct {
+    const char* ptr;
+    const cdex_descriptor_t* desc;
+    cdex_filter_t* filter;
+    int depth;
+    bool error;
+} filter_parser_t;
+
+bool cdex_type_is_numeric(cdex_data_type_t type) {
+    return type != CDEX_TYPE_STR && type != CDEX_TYPE_BIN && type != CDEX_TYPE_DSTR && type != CDEX_TYPE_UNKNOWN;
+}
+
+double cdex_value_to_double(cdex_data_type_t type, const cdex_value_t* value) {
+    switch (type) {
+        case CDEX_TYPE_U8: return value->u8;
+        case CDEX_TYPE_I8: return value->i8;
+        case CDEX_TYPE_U16: return value->u16;
+        case CDEX_TYPE_I16: return value->i16;
+        case CDEX_TYPE_U32: return value->u32;
+        case CDEX_TYPE_I32: return value->i32;
+        case CDEX_TYPE_U64: return (double)value->u64;
+        case CDEX_TYPE_I64: return (double)value->i64;
+        case CDEX_TYPE_NUM: return (double)value->i64;
+        case CDEX_TYPE_F32: return value->f32;
+        case CDEX_TYPE_D64: return value->d64;
+        case CDEX_TYPE_U1: case CDEX_TYPE_U2: case CDEX_TYPE_U3: case CDEX_TYPE_U4:
+        case CDEX_TYPE_U5: case CDEX_TYPE_U6: case CDEX_TYPE_U7:
+        case CDEX_TYPE_B1: return value->u8;
+        case CDEX_TYPE_F16: return value->f32;
+        case CDEX_TYPE_S8: case CDEX_TYPE_S16: case CDEX_TYPE_S32: return value->d64;
+        default: return 0;
+    }
+}
+
+static void filter_skip_spaces(filter_parser_t* parser) {
+    while (*parser->ptr == ' ' || *parser->ptr == '\t') parser->ptr++;
+}
+
+static void filter_emit(filter_parser_t* parser, int8_t op) {
+    if (parser->filter->op_count >= CDEX_FILTER_MAX_OPS) {
+        parser->error = true;
+        return;
+    }
+    parser->filter->program[parser->filter->op_count++] = op;
+}
+
+static void filter_parse_or(filter_parser_t* parser);
+
+static void filter_parse_term(filter_parser_t* parser) {
+    filter_skip_spaces(parser);
+    const char* name = parser->ptr;
+    while ((*parser->ptr >= 'a' && *parser->ptr <= 'z') || (*parser->ptr >= 'A' && *parser->ptr <= 'Z') ||
+           (*parser->ptr >= '0' && *parser->ptr <= '9') || *parser->ptr == '_' || *parser->ptr == '.') {
+        parser->ptr++;
+    }
+    size_t name_len = parser->ptr - name;
+    int field_index = -1;
+    for (int i = 0; i < parser->desc->field_count && name_len > 0; ++i) {
+        if (strlen(parser->desc->fields[i].name) == name_len &&
+            strncmp(parser->desc->fields[i].name, name, name_len) == 0) {
+            field_index = i;
+            break;
+        }
+    }
+    if (field_index < 0 || !cdex_type_is_numeric(parser->desc->fields[field_index].type)) {
+        parser->error = true;
+        return;
+    }
+
+    filter_skip_spaces(parser);
+    cdex_cmp_op_t op;
+    const char* p = parser->ptr;
+    if (p[0] == '<' && p[1] == '=') { op = CDEX_CMP_LE; parser->ptr += 2; }
+    else if (p[0] == '>' && p[1] == '=') { op = CDEX_CMP_GE; parser->ptr += 2; }
+    else if (p[0] == '=' && p[1] == '=') { op = CDEX_CMP_EQ; parser->ptr += 2; }
+    else if (p[0] == '!' && p[1] == '=') { op = CDEX_CMP_NE; parser->ptr += 2; }
+    else if (p[0] == '<') { op = CDEX_CMP_LT; parser->ptr += 1; }
+    else if (p[0] == '>') { op = CDEX_CMP_GT; parser->ptr += 1; }
+    else {
+        parser->error = true;
+        return;
+    }
+
+    filter_skip_spaces(parser);
+    char* number_end;
+    double operand = strtod(parser->ptr, &number_end);
+    if (number_end == parser->ptr) {
+        parser->error = true;
+        return;
+    }
+    parser->ptr = number_end;
+
+    cdex_filter_t* filter = parser->filter;
+    if (filter->term_count >= CDEX_FILTER_MAX_TERMS) {
+        parser->error = true;
+        return;
+    }
+    filter->terms[filter->term_count].field_index = field_index;
+    filter->terms[filter->term_count].op = op;
+    filter->terms[filter->term_count].operand = operand;
+    filter_emit(parser, (int8_t)filter->term_count);
+    filter->term_count++;
+}
+
+static void filter_parse_unary(filter_parser_t* parser) {
+    // 限制递归深度，避免恶意表达式耗尽栈
+    if (++parser->depth > FILTER_MAX_DEPTH) {
+        parser->error = true;
+        return;
+    }
+    filter_skip_spaces(parser);
+    if (*parser->ptr == '!' && parser->ptr[1] != '=') {
+        parser->ptr++;
+        filter_parse_unary(parser);
+        filter_emit(parser, FILTER_OP_NOT);
+    } else if (*parser->ptr == '(') {
+        parser->ptr++;
+        filter_parse_or(parser);
+        filter_skip_spaces(parser);
+        if (*parser->ptr != ')') {
+            parser->error = true;
+            return;
+        }
+        parser->ptr++;
+    } else {
+        filter_parse_term(parser);
+    }
+    parser->depth--;
+}
+
+static void filter_parse_and(filter_parser_t* parser) {
+    filter_parse_unary(parser);
+    while (!parser->error) {
+        filter_skip_spaces(parser);
+        if (parser->ptr[0] != '&' || parser->ptr[1] != '&') break;
+        parser->ptr += 2;
+        filter_parse_unary(parser);
+        filter_emit(parser, FILTER_OP_AND);
+    }
+}
+
+static void filter_parse_or(filter_parser_t* parser) {
+    filter_parse_and(parser);
+    while (!parser->error) {
+        filter_skip_spaces(parser);
+        if (parser->ptr[0] != '|' || parser->ptr[1] != '|') break;
+        parser->ptr += 2;
+        filter_parse_and(parser);
+        filter_emit(parser, FILTER_OP_OR);
+    }
+}
+
+cdex_status_t cdex_filter_compile(cdex_filter_t* filter, const cdex_descriptor_t* desc, const char* expr) {
+    if (!filter || !desc || !expr) return CDEX_ERROR_INVALID_DATA;
+    memset(filter, 0, sizeof(cdex_filter_t));
+    filter->descriptor_id = desc->id;
+
+    filter_parser_t parser = { expr, desc, filter, 0, false };
+    filter_parse_or(&parser);
+    filter_skip_spaces(&parser);
+    if (parser.error || *parser.ptr != '\0') return CDEX_ERROR_INVALID_DATA;
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 对一列数值做同一比较，结果写入位掩码；每个分支内是无依赖的简单循环，便于向量化
+ */
+static uint64_t filter_compare_column(const double* values, int count, cdex_cmp_op_t op, double operand) {
+    uint8_t hits[CDEX_FILTER_BATCH];
+    switch (op) {
+        case CDEX_CMP_LT: for (int k = 0; k < count; ++k) hits[k] = values[k] < operand; break;
+        case CDEX_CMP_LE: for (int k = 0; k < count; ++k) hits[k] = values[k] <= operand; break;
+        case CDEX_CMP_GT: for (int k = 0; k < count; ++k) hits[k] = values[k] > operand; break;
+        case CDEX_CMP_GE: for (int k = 0; k < count; ++k) hits[k] = values[k] >= operand; break;
+        case CDEX_CMP_EQ: for (int k = 0; k < count; ++k) hits[k] = values[k] == operand; break;
+        case CDEX_CMP_NE: for (int k = 0; k < count; ++k) hits[k] = values[k] != operand; break;
+        default: return 0;
+    }
+    uint64_t mask = 0;
+    for (int k = 0; k < count; ++k) {
+        mask |= (uint64_t)hits[k] << k;
+    }
+    return mask;
+}
+
+/**
+ * @brief 求值最多 CDEX_FILTER_BATCH 个帧，返回通过帧的位掩码
+ */
+static uint64_t filter_eval_chunk(const cdex_filter_t* filter, const uint8_t* const* frames, const size_t* lens, int count) {
+    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(filter->descriptor_id);
+    if (!desc) return 0;
+
+    // 先按帧取出所有比较项用到的字段值，再按列比较
+    double values[CDEX_FILTER_MAX_TERMS][CDEX_FILTER_BATCH];
+    uint64_t present[CDEX_FILTER_MAX_TERMS] = { 0 };
+    uint64_t valid = 0;
+    uint64_t dict_adds = 0;
+    for (int k = 0; k < count; ++k) {
+        cdex_reader_t reader;
+        bool ok = reader_setup(&reader, frames[k], lens[k], false) == CDEX_SUCCESS &&
+                  reader.desc->id == filter->descriptor_id;
+        if (ok) valid |= 1ULL << k;
+        if (ok && reader_carries_dict_add(&reader)) dict_adds |= 1ULL << k;
+        for (int t = 0; t < filter->term_count; ++t) {
+            const cdex_filter_term_t* term = &filter->terms[t];
+            cdex_value_t value;
+            values[t][k] = 0;
+            if (ok && cdex_reader_get(&reader, term->field_index, &value) == CDEX_SUCCESS) {
+                values[t][k] = cdex_value_to_double(desc->fields[term->field_index].type, &value);
+                present[t] |= 1ULL << k;
+            }
+        }
+    }
+
+    uint64_t stack[CDEX_FILTER_MAX_OPS];
+    int depth = 0;
+    for (int i = 0; i < filter->op_count; ++i) {
+        int8_t op = filter->program[i];
+        if (op >= 0) {
+            const cdex_filter_term_t* term = &filter->terms[op];
+            stack[depth++] = filter_compare_column(values[op], count, term->op, term->operand) & present[op];
+        } else if (op == FILTER_OP_NOT) {
+            stack[depth - 1] = ~stack[depth - 1];
+        } else {
+            depth--;
+            if (op == FILTER_OP_AND) {
+                stack[depth - 1] &= stack[depth];
+            } else {
+                stack[depth - 1] |= stack[depth];
+            }
+        }
+    }
+    // 带有新增字典条目的帧总是通过，交给 cdex_parse 更新字典
+    return depth == 1 ? (stack[0] | dict_adds) & valid : 0;
+}
+
+bool cdex_filter_match(const cdex_filter_t* filter, const uint8_t* buffer, size_t buffer_len) {
+    if (!filter || !buffer) return false;
+    return filter_eval_chunk(filter, &buffer, &buffer_len, 1) & 1;
+}
+
+int cdex_filter_match_batch(const cdex_filter_t* filter, const uint8_t* const* frames, const size_t* lens,
+                            int count, uint8_t* pass) {
+    if (!filter || !frames || !lens || !pass) return 0;
+    int passed = 0;
+    for (int base = 0; base < count; base += CDEX_FILTER_BATCH) {
+        int chunk = count - base < CDEX_FILTER_BATCH ? count - base : CDEX_FILTER_BATCH;
+        uint64_t mask = filter_eval_chunk(filter, frames + base, lens + base, chunk);
+        for (int k = 0; k < chunk; ++k) {
+            pass[base + k] = (mask >> k) & 1;
+            passed += pass[base + k];
+        }
+    }
+    return passed;
 }
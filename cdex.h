@@ -9,6 +9,32 @@
 
 #define CDEX_MAX_FIELDS 64
 #define CDEX_FIELD_NAME_LEN 32
+#define CDEX_MAX_ROUTES 32
+#define CDEX_FILTER_MAX_TERMS 8
+#define CDEX_FILTER_MAX_OPS 32
+#define CDEX_FILTER_BATCH 64
+#define CDEX_DICT_MAX_ENTRIES 64
+#define CDEX_DICT_POOL_SIZE 1024
+#define CDEX_RESERVED_ID 0xFFFF // 保留给链路上的控制消息，不能注册为描述符
+
+/*
+ * 定义 CDEX_NO_HEAP 时整个库不使用堆内存：
+ * - 描述符节点和转码表来自编译期固定容量的静态池，容量可通过下面的宏覆盖；
+ * - 描述符只能通过 cdex_descriptor_load_static 引用调用者的常量表 (可放在 flash 中)，
+ *   cdex_descriptor_register 和 cdex_descriptor_load 返回 CDEX_ERROR_MEMORY_ALLOCATION；
+ * - cdex_parse 得到的 str/bin 值均为指向输入缓冲区的视图，cdex_free_packet_memory 不做任何事。
+ */
+#ifdef CDEX_NO_HEAP
+#ifdef CDEX_PARSE_TO_JSON
+#error "CDEX_PARSE_TO_JSON requires heap allocation and cannot be used with CDEX_NO_HEAP"
+#endif
+#ifndef CDEX_MAX_DESCRIPTORS
+#define CDEX_MAX_DESCRIPTORS 16
+#endif
+#ifndef CDEX_MAX_TRANSCODERS
+#define CDEX_MAX_TRANSCODERS 8 // 每次 cdex_descriptor_link_version 占用两项
+#endif
+#endif
 
 /**
  * @brief 可用的 CDEX 数据类型枚举
@@ -22,6 +48,13 @@ typedef enum {
     CDEX_TYPE_F32, CDEX_TYPE_D64,
     CDEX_TYPE_BIN,
     CDEX_TYPE_STR,
+    // 不足一字节的无符号整数，相邻的位字段按位紧凑排列
+    CDEX_TYPE_U1, CDEX_TYPE_U2, CDEX_TYPE_U3, CDEX_TYPE_U4,
+    CDEX_TYPE_U5, CDEX_TYPE_U6, CDEX_TYPE_U7,
+    CDEX_TYPE_B1, // 布尔标志位
+    CDEX_TYPE_F16, // 半精度浮点
+    CDEX_TYPE_S8, CDEX_TYPE_S16, CDEX_TYPE_S32, // 定点数，传输值 = 实际值 / scale
+    CDEX_TYPE_DSTR, // 字典编码字符串
     CDEX_TYPE_UNKNOWN
 } cdex_data_type_t;
 
@@ -29,7 +62,7 @@ typedef enum {
  * @brief 保存不同数据类型的通用联合体类型
  */
 typedef union {
-    uint8_t u8;
+    uint8_t u8;   // u1~u7 和 b1 也使用此成员
     int8_t i8;
     uint16_t u16;
     int16_t i16;
@@ -37,20 +70,34 @@ typedef union {
     int32_t i32;
     uint64_t u64;
     int64_t i64;  // varint will use this
-    float f32;
-    double d64;
+    float f32;    // f16 也使用此成员
+    double d64;   // s8/s16/s32 定点数解码后使用此成员
     /* Dynamic: MUST call cdex_free_packet_memory() to release */
     char* str;    // end with '\0'
     uint8_t* bin; // first byte for length
 } cdex_value_t;
 
+/**
+ * @brief 字符串字典，dstr 字段的值以字典索引传输
+ *
+ * 所有字符串保存在结构体内的字符串池中，不使用堆内存；解码得到的字典字符串直接指向字符串池。
+ */
+typedef struct {
+    int count;                                  // 已使用的索引上限
+    size_t pool_used;
+    bool auto_add;                              // 编码时是否把未命中的字符串以带内方式加入字典
+    uint16_t offsets[CDEX_DICT_MAX_ENTRIES];    // 字符串在 pool 中的偏移，0xFFFF 表示空
+    char pool[CDEX_DICT_POOL_SIZE];
+} cdex_dict_t;
+
 /**
  * @brief 单个字段的描述信息
  */
 typedef struct {
-    char name[CDEX_FIELD_NAME_LEN];
+    const char* name;       // 动态注册的描述符中指向共享的名称池，最长 CDEX_FIELD_NAME_LEN - 1 个字符
     cdex_data_type_t type;
-    size_t size;
+    uint8_t size;           // 定长字段的字节数，变长字段和位字段为0
+    double scale;           // 定点数的缩放系数，为0时按1处理，其它类型忽略
 } cdex_field_t;
 
 /**
@@ -58,17 +105,30 @@ typedef struct {
  */
 typedef struct {
     uint16_t id;
-    char* raw_string;
+    const char* raw_string; // 注册时不保留，需要时用 cdex_fields_to_string 重新生成
     int field_count;
-    cdex_field_t fields[CDEX_MAX_FIELDS];
+    const cdex_field_t* fields;
 } cdex_descriptor_t;
 
 /**
- * @brief CDEX 描述符链表的节点结构体。
+ * @brief 注册时预先计算的描述符布局，用于 O(1) 计算字段偏移
+ */
+typedef struct {
+    uint64_t var_mask;       // 变长字段 (num/bin/str) 和位字段
+    uint64_t dict_mask;      // dstr 字段
+    uint64_t size_masks[4];  // 1/2/4/8 字节的定长字段
+} cdex_layout_t;
+
+/**
+ * @brief 描述符注册表中的一条记录
+ *
+ * 动态注册时节点与字段表一次分配，字段表紧跟在节点之后，大小随字段数变化；
+ * cdex_descriptor_load_static 加载的描述符直接引用调用者的字段表。
  */
 typedef struct cdex_descriptor_node {
     cdex_descriptor_t descriptor;
-    struct cdex_descriptor_node* next;
+    cdex_layout_t layout;
+    cdex_dict_t* dict; // dstr 字段使用的字典，可为NULL
 } cdex_descriptor_node_t;
 
 /**
@@ -77,10 +137,27 @@ typedef struct cdex_descriptor_node {
 typedef struct {
     uint16_t descriptor_id;
     uint64_t bitmap;
+    uint64_t borrowed; // 指向共享存储 (如字符串字典) 的字段，cdex_free_packet_memory 不会释放
     int data_count;
     cdex_value_t values[CDEX_MAX_FIELDS]; // 按bitmap顺序存放数据
 } cdex_packet_t;
 
+/**
+ * @brief 投影路由表项：某个描述符ID需要保留的字段
+ */
+typedef struct {
+    uint16_t descriptor_id;
+    uint64_t keep_mask;
+} cdex_route_t;
+
+/**
+ * @brief 投影路由表，按描述符ID决定保留哪些字段，表中没有的ID直接丢弃
+ */
+typedef struct {
+    int route_count;
+    cdex_route_t routes[CDEX_MAX_ROUTES];
+} cdex_route_table_t;
+
 /**
  * @brief CDEX 状态码
  */
@@ -94,9 +171,56 @@ typedef enum {
     CDEX_ERROR_MEMORY_ALLOCATION,
     CDEX_ERROR_INDEX_OUT_OF_BOUNDS,
     CDEX_ERROR_PACKET_FULL,
-    CDEX_ERROR_ID_EXISTS
+    CDEX_ERROR_ID_EXISTS,
+    CDEX_PENDING_DESCRIPTOR,
+    CDEX_ERROR_QUEUE_FULL,
+    CDEX_ERROR_FIELD_NOT_PRESENT
 } cdex_status_t;
 
+/**
+ * @brief 过滤表达式中的比较运算符
+ */
+typedef enum {
+    CDEX_CMP_LT, CDEX_CMP_LE,
+    CDEX_CMP_GT, CDEX_CMP_GE,
+    CDEX_CMP_EQ, CDEX_CMP_NE
+} cdex_cmp_op_t;
+
+/**
+ * @brief 过滤表达式中的单个比较项：字段 运算符 常量
+ */
+typedef struct {
+    int field_index;
+    cdex_cmp_op_t op;
+    double operand;
+} cdex_filter_term_t;
+
+/**
+ * @brief 针对某个描述符编译好的过滤器
+ */
+typedef struct {
+    uint16_t descriptor_id;
+    int term_count;
+    cdex_filter_term_t terms[CDEX_FILTER_MAX_TERMS];
+    int op_count;
+    int8_t program[CDEX_FILTER_MAX_OPS]; // 逆波兰表达式：非负数为比较项索引，负数为逻辑运算
+} cdex_filter_t;
+
+/**
+ * @brief 字节流上的随机访问读取器，字符串和二进制字段以视图形式返回，不分配内存
+ */
+typedef struct {
+    const cdex_descriptor_t* desc;
+    const cdex_layout_t* layout;
+    cdex_dict_t* dict;
+    uint64_t bitmap;
+    const uint8_t* payload;
+    const uint8_t* payload_end;
+    int indexed_count;                  // 已建立偏移索引的字段数 (按描述符字段索引)
+    uint32_t index_bit_offset;          // 偏移索引构建到的位置
+    uint32_t offsets[CDEX_MAX_FIELDS];  // 相对 payload 的字段位偏移
+} cdex_reader_t;
+
 
 /**
  * @brief 初始化描述符管理器
@@ -110,8 +234,10 @@ void cdex_manager_cleanup(void);
 
 /**
  * @brief 通过描述符字符串动态注册一个新的描述符
+ *
+ * 所有注册接口都拒绝保留的 CDEX_RESERVED_ID，返回 CDEX_ERROR_INVALID_DATA。
  * @param id 要注册的描述符ID
- * @param descriptor_string 描述符字符串，例如 "temp-f32,hum-u16"
+ * @param descriptor_string 描述符字符串，例如 "temp:f32,hum:u16,alarm:b1,level:u3,volt:s16:0.01"
  * @return 状态码 (CDEX_SUCCESS 表示成功)
  */
 cdex_status_t cdex_descriptor_register(uint16_t id, const char* descriptor_string);
@@ -120,11 +246,32 @@ cdex_status_t cdex_descriptor_register(uint16_t id, const char* descriptor_strin
  * @brief 通过预定义的字段数组加载一个新的描述符
  * @param id 要加载的描述符ID
  * @param fields 指向 cdex_field_t 数组的指针
- * @param field_count 数组中的字段数量
+ * @param field_count 数组中的字段数量，字段的 size 由类型决定，忽略调用者填写的值
  * @return 状态码 (CDEX_SUCCESS 表示成功)
  */
 cdex_status_t cdex_descriptor_load(uint16_t id, const cdex_field_t* fields, int field_count);
 
+/**
+ * @brief 加载一个常量描述符，只引用其字段表而不拷贝
+ *
+ * 字段表和字段名可以声明为 const 全局变量放在 flash 中，在 cdex_manager_cleanup 之前必须一直有效。
+ * 字段的 size 需与类型一致 (变长字段和位字段为0)。
+ * @param desc 指向描述符，raw_string 可为NULL
+ * @return 状态码 (CDEX_SUCCESS 表示成功)，size 与类型不一致时返回 CDEX_ERROR_INVALID_DATA，
+ *         静态池已满时返回 CDEX_ERROR_MEMORY_ALLOCATION
+ */
+cdex_status_t cdex_descriptor_load_static(const cdex_descriptor_t* desc);
+
+/**
+ * @brief 将字段表转换为描述符字符串，例如 "temp:f32,volt:s16:0.01"
+ * @param buf 输出缓冲区
+ * @param buf_size 缓冲区大小
+ * @param fields 字段数组
+ * @param field_count 字段数量
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_fields_to_string(char* buf, size_t buf_size, const cdex_field_t* fields, int field_count);
+
 /**
  * @brief 根据ID查找一个已初始化的描述符
  * @param id 描述符ID
@@ -132,24 +279,226 @@ cdex_status_t cdex_descriptor_load(uint16_t id, const cdex_field_t* fields, int
  */
 const cdex_descriptor_t* cdex_get_descriptor_by_id(uint16_t id);
 
+/**
+ * @brief 初始化字符串字典
+ * @param dict 指向字典
+ * @param auto_add 编码端未命中时是否自动以带内方式加入新条目；收发双方预先约定的固定字典应设为 false
+ */
+void cdex_dict_init(cdex_dict_t* dict, bool auto_add);
+
+/**
+ * @brief 向字典追加一个字符串，已存在时返回已有索引
+ * @param index_out [out] 字符串的索引，可为NULL
+ * @return 状态码 (CDEX_SUCCESS 表示成功)，字典已满时返回 CDEX_ERROR_PACKET_FULL
+ */
+cdex_status_t cdex_dict_add(cdex_dict_t* dict, const char* str, int* index_out);
+
+/**
+ * @brief 在指定索引处设置字符串，用于接收带内新增的条目
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_dict_set(cdex_dict_t* dict, int index, const char* str);
+
+/**
+ * @brief 查找字符串的索引
+ * @return 索引，不存在返回-1
+ */
+int cdex_dict_find(const cdex_dict_t* dict, const char* str);
+
+/**
+ * @brief 获取索引对应的字符串
+ * @return 字符串，不存在返回NULL
+ */
+const char* cdex_dict_get(const cdex_dict_t* dict, int index);
+
+/**
+ * @brief 为描述符绑定字典，cdex_pack/cdex_parse 对该描述符的 dstr 字段使用此字典
+ * @param id 描述符ID
+ * @param dict 字典，需在描述符生命周期内有效，NULL 表示解除绑定
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_descriptor_bind_dict(uint16_t id, cdex_dict_t* dict);
+
+/**
+ * @brief 声明 new_id 是 old_id 的新版本，按字段名称和类型预先计算双向的字段映射表
+ * @param old_id 旧版本描述符ID
+ * @param new_id 新版本描述符ID
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_descriptor_link_version(uint16_t old_id, uint16_t new_id);
+
+/**
+ * @brief 将 CDEX 字节流在两个已关联的描述符版本之间转码，不解码字段值、不分配内存
+ *
+ * 目标版本中不存在的字段会被丢弃，目标版本中新增的字段不会出现在输出中。
+ * 两个版本绑定的字典不同时，dstr 字段按源字典解出后改写为字面量。
+ * @param buffer 源字节流
+ * @param buffer_len 源字节流长度
+ * @param target_id 目标描述符ID
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小
+ * @return 成功则返回输出的字节数，失败返回-1
+ */
+int cdex_transcode(const uint8_t* buffer, size_t buffer_len, uint16_t target_id, uint8_t* out, size_t out_size);
+
 /**
  * @brief 将 cdex_packet_t 数据打包成 CDEX 字节流
  * @param packet 指向待打包的数据包结构体
  * @param buffer 输出缓冲区
  * @param buffer_size 缓冲区大小
- * @return 成功则返回打包后的字节数，失败返回-1
+ * @return 成功则返回打包后的字节数，失败返回-1 (包括 u1~u7 字段的值不小于 1 << 位宽)
  */
 int cdex_pack(const cdex_packet_t* packet, uint8_t* buffer, size_t buffer_size);
 
+/**
+ * @brief 使用指定的会话字典打包，用于同一描述符下每个会话各自维护字典的场景
+ * @return 成功则返回打包后的字节数，失败返回-1
+ */
+int cdex_pack_with_dict(const cdex_packet_t* packet, cdex_dict_t* dict, uint8_t* buffer, size_t buffer_size);
+
+/**
+ * @brief 按 MTU 把数据包拆分为多个 CDEX 帧，每帧携带字段的一个子集及对应的 DataMask
+ *
+ * 字段按编码后的大小从大到小首次适配到帧中，位字段按位计算，帧数接近最少。
+ * 帧依次紧密写入 buffer，每帧都是可以单独解析的完整帧。
+ * @param packet 指向要打包的数据包
+ * @param mtu 每帧的最大字节数
+ * @param buffer 输出缓冲区
+ * @param buffer_size 缓冲区大小
+ * @param frame_lens [out] 每帧的字节数
+ * @param max_frames frame_lens 的容量
+ * @return 成功则返回帧数，单个字段加上帧头和 CRC 已超过 MTU 或缓冲区不足时返回-1
+ */
+int cdex_pack_mtu(const cdex_packet_t* packet, size_t mtu, uint8_t* buffer, size_t buffer_size,
+                  int* frame_lens, int max_frames);
+
 /**
  * @brief 将 CDEX 字节流解析到 cdex_packet_t 结构体中
  * @param buffer 包含CDEX字节流的缓冲区
  * @param buffer_len 缓冲区中的数据长度
- * @param packet_out 指向用于存储解析结果的结构体指针
+ * @param packet_out 指向用于存储解析结果的结构体指针，无论成败都会被初始化，失败后同样需要
+ *                   cdex_free_packet_memory 释放已解码的部分
  * @return 状态码 (CDEX_SUCCESS 表示成功)
  */
 cdex_status_t cdex_parse(const uint8_t* buffer, size_t buffer_len, cdex_packet_t* packet_out);
 
+/**
+ * @brief 使用指定的会话字典解析，带内新增的条目会写入该字典
+ * @note packet_out 的初始化与释放约定同 cdex_parse
+ * @return 状态码 (CDEX_SUCCESS 表示成功)，新增条目无法写入字典时返回 cdex_dict_set 的错误码
+ */
+cdex_status_t cdex_parse_with_dict(const uint8_t* buffer, size_t buffer_len, cdex_dict_t* dict, cdex_packet_t* packet_out);
+
+/**
+ * @brief 直接在字节流上做字段投影，只拷贝保留字段的字节，重写 DataMask 并重新计算 CRC
+ *
+ * 带有带内新增字典条目的 dstr 字段即使不在 keep_mask 中也会保留，以免接收端字典失步。
+ * @param buffer 源字节流
+ * @param buffer_len 源字节流长度
+ * @param keep_mask 需要保留的字段位图
+ * @param out 输出缓冲区
+ * @param out_size 输出缓冲区大小
+ * @return 成功则返回输出的字节数，失败返回-1
+ */
+int cdex_project(const uint8_t* buffer, size_t buffer_len, uint64_t keep_mask, uint8_t* out, size_t out_size);
+
+/**
+ * @brief 初始化投影路由表
+ */
+void cdex_route_table_init(cdex_route_table_t* table);
+
+/**
+ * @brief 设置某个描述符ID需要保留的字段，已存在则覆盖
+ * @return 状态码 (CDEX_SUCCESS 表示成功)，路由表已满 (CDEX_MAX_ROUTES) 时返回 CDEX_ERROR_QUEUE_FULL
+ */
+cdex_status_t cdex_route_table_set(cdex_route_table_t* table, uint16_t descriptor_id, uint64_t keep_mask);
+
+/**
+ * @brief 按路由表投影，在校验 CRC 之前即可丢弃不需要的包，带有新增字典条目的包不会被丢弃
+ * @return 成功则返回输出的字节数，包被丢弃返回0，失败返回-1
+ */
+int cdex_project_routed(const cdex_route_table_t* table, const uint8_t* buffer, size_t buffer_len,
+                        uint8_t* out, size_t out_size);
+
+/**
+ * @brief 初始化读取器，只校验一次 CRC，不解析字段
+ * @param reader 指向读取器
+ * @param buffer 包含CDEX字节流的缓冲区，需在读取器使用期间保持有效
+ * @param buffer_len 缓冲区中的数据长度
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_reader_init(cdex_reader_t* reader, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief 判断字段是否存在于数据包中
+ */
+bool cdex_reader_has(const cdex_reader_t* reader, int field_index);
+
+/**
+ * @brief 按需读取单个字段
+ *
+ * 前面只有定长字段时偏移直接由布局表计算，否则在首次访问时惰性建立偏移索引。
+ * str/bin/dstr 字段返回指向 buffer 或字典的视图，不能调用 cdex_free_packet_memory 释放；
+ * 读取器不会把带内新增的字典条目写入字典。
+ * @param reader 指向读取器
+ * @param field_index 字段在其描述符中的索引
+ * @param value 输出的字段值
+ * @return 状态码，字段不存在时返回 CDEX_ERROR_FIELD_NOT_PRESENT
+ */
+cdex_status_t cdex_reader_get(cdex_reader_t* reader, int field_index, cdex_value_t* value);
+
+/**
+ * @brief 读取 str/dstr 字段，返回指向 buffer 或字典的以 '\0' 结尾的字符串视图
+ */
+cdex_status_t cdex_reader_get_str(cdex_reader_t* reader, int field_index, const char** str);
+
+/**
+ * @brief 读取 bin 字段，返回指向 buffer 的数据视图 (不含长度字节)
+ */
+cdex_status_t cdex_reader_get_bin(cdex_reader_t* reader, int field_index, const uint8_t** data, size_t* len);
+
+/**
+ * @brief 判断类型是否为数值类型 (str/bin/dstr 以外的类型)
+ */
+bool cdex_type_is_numeric(cdex_data_type_t type);
+
+/**
+ * @brief 把数值字段的值转换为 double，定点数为缩放后的实际值，str/bin/dstr 返回0
+ */
+double cdex_value_to_double(cdex_data_type_t type, const cdex_value_t* value);
+
+/**
+ * @brief 针对描述符编译过滤表达式
+ *
+ * 支持数值字段与常量的比较 (<, <=, >, >=, ==, !=)，以及 &&、||、! 和括号，
+ * 例如 "temp>30 || status!=0"。
+ * @param filter 指向输出的过滤器
+ * @param desc 表达式所针对的描述符
+ * @param expr 过滤表达式
+ * @return 状态码，语法错误、! 与括号嵌套超过 CDEX_FILTER_MAX_OPS 层、字段不存在或字段不是数值类型时返回 CDEX_ERROR_INVALID_DATA
+ */
+cdex_status_t cdex_filter_compile(cdex_filter_t* filter, const cdex_descriptor_t* desc, const char* expr);
+
+/**
+ * @brief 直接在字节流上求值过滤器，不校验 CRC (通过的帧仍需经过 cdex_parse)
+ *
+ * 字段不存在时对应的比较项为假；描述符ID不匹配或帧不完整时返回 false。
+ * 带有带内新增字典条目的帧总是通过，由后续的 cdex_parse 更新字典。
+ */
+bool cdex_filter_match(const cdex_filter_t* filter, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief 批量求值同一描述符的多个帧，按列比较以便编译器向量化
+ * @param filter 指向过滤器
+ * @param frames 帧指针数组
+ * @param lens 帧长度数组
+ * @param count 帧数量
+ * @param pass [out] 每个帧的结果，1 为通过，0 为丢弃
+ * @return 通过的帧数
+ */
+int cdex_filter_match_batch(const cdex_filter_t* filter, const uint8_t* const* frames, const size_t* lens,
+                            int count, uint8_t* pass);
+
 #ifdef CDEX_PARSE_TO_JSON
 /**
  * @brief 将解析后的 cdex_packet_t 转换为 cJSON 对象
@@ -183,6 +532,24 @@ cdex_status_t cdex_packet_push(cdex_packet_t* packet, int field_index, cdex_valu
  */
 cdex_status_t cdex_packet_pop(cdex_packet_t* packet, int field_index);
 
+/**
+ * @brief 把 cdex_pack_mtu 拆分出的帧解析后合并回一个数据包
+ *
+ * 成功时 part 中的字段 (包括动态内存的所有权) 转移到 dest，part 变为空包。
+ * 描述符ID不同、字段重叠、dest 已经完整或 part 含有 expected_mask 之外的字段时
+ * 返回 CDEX_ERROR_INVALID_DATA 且不修改两者，通常说明 part 属于下一个数据包，
+ * 调用者应先交付 dest 再以 part 重新开始。
+ *
+ * 分片本身不携带包序号。expected_mask 为0时只能靠字段重叠判断包边界，
+ * 字段集合互不相交的相邻数据包会被错误合并，因此只在每个数据包都携带相同字段时才安全。
+ * 能确定完整字段集合时应传入 expected_mask，并在 dest->bitmap == expected_mask 时立即交付。
+ * @param dest 合并目标
+ * @param part 新解析的分片
+ * @param expected_mask 完整数据包的字段位图，0 表示未知
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_packet_merge(cdex_packet_t* dest, cdex_packet_t* part, uint64_t expected_mask);
+
 /**
  * @brief 计算当前数据包打包后所需的字节数
  * @param packet 指向要计算的数据包
@@ -191,7 +558,7 @@ cdex_status_t cdex_packet_pop(cdex_packet_t* packet, int field_index);
 int cdex_packet_calculate_packed_size(const cdex_packet_t* packet);
 
 /**
- * @brief 释放由 cdex_parse 动态分配的内存
+ * @brief 释放由 cdex_parse 动态分配的内存，borrowed 中标记的字段不会被释放 (CDEX_NO_HEAP 时为空操作)
  * @param packet 指向已解析的数据包
  */
 void cdex_free_packet_memory(cdex_packet_t* packet);
@@ -0,0 +1,330 @@
+// 本模块依赖堆内存，CDEX_NO_HEAP 构建中编译为空
+#ifndef CDEX_NO_HEAP
+#include "cdex_agg.h"
+#include <string.h>
+#include <stdio.h>
+
+static int lowest_set_bit(uint64_t n) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(n);
+#else
+    int index = 0;
+    while (!(n & 1)) {
+        n >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+static bool is_wide_type(cdex_data_type_t type) {
+    return type == CDEX_TYPE_U64 || type == CDEX_TYPE_I64 || type == CDEX_TYPE_D64 || type == CDEX_TYPE_NUM;
+}
+
+/**
+ * @brief 把聚合值按源字段类型放回 cdex_value_t，用于重新编码
+ */
+static cdex_value_t value_from_double(cdex_data_type_t type, double v) {
+    cdex_value_t value;
+    memset(&value, 0, sizeof(value));
+    switch (type) {
+        case CDEX_TYPE_U8: value.u8 = (uint8_t)v; break;
+        case CDEX_TYPE_I8: value.i8 = (int8_t)v; break;
+        case CDEX_TYPE_U16: value.u16 = (uint16_t)v; break;
+        case CDEX_TYPE_I16: value.i16 = (int16_t)v; break;
+        case CDEX_TYPE_U32: value.u32 = (uint32_t)v; break;
+        case CDEX_TYPE_I32: value.i32 = (int32_t)v; break;
+        case CDEX_TYPE_U64: value.u64 = (uint64_t)v; break;
+        case CDEX_TYPE_I64: value.i64 = (int64_t)v; break;
+        case CDEX_TYPE_NUM: value.i64 = (int64_t)v; break;
+        case CDEX_TYPE_F32: case CDEX_TYPE_F16: value.f32 = (float)v; break;
+        case CDEX_TYPE_U1: case CDEX_TYPE_U2: case CDEX_TYPE_U3: case CDEX_TYPE_U4:
+        case CDEX_TYPE_U5: case CDEX_TYPE_U6: case CDEX_TYPE_U7:
+        case CDEX_TYPE_B1: value.u8 = (uint8_t)v; break;
+        default: value.d64 = v; break; // d64 和 s8/s16/s32 定点数
+    }
+    return value;
+}
+
+static bool summary_matches(const cdex_descriptor_t* desc, const cdex_field_t* fields, int count) {
+    if (!desc || desc->field_count != count) return false;
+    for (int i = 0; i < count; ++i) {
+        const cdex_field_t* field = &desc->fields[i];
+        if (field->type != fields[i].type || field->size != fields[i].size || field->scale != fields[i].scale ||
+            strcmp(field->name, fields[i].name) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static cdex_status_t register_summary(const cdex_aggregator_t* agg) {
+    static const char* suffixes[4] = { "_min", "_max", "_mean", "_last" };
+    char names[CDEX_AGG_SUMMARY_FIXED + 4 * CDEX_AGG_MAX_COLUMNS][CDEX_FIELD_NAME_LEN];
+    cdex_field_t fields[CDEX_AGG_SUMMARY_FIXED + 4 * CDEX_AGG_MAX_COLUMNS];
+    memset(fields, 0, sizeof(fields));
+
+    fields[0].name = "device";
+    fields[0].type = CDEX_TYPE_NUM;
+    fields[1].name = "window_start";
+    fields[1].type = CDEX_TYPE_U64;
+    fields[1].size = 8;
+    fields[2].name = "count";
+    fields[2].type = CDEX_TYPE_NUM;
+
+    int count = CDEX_AGG_SUMMARY_FIXED;
+    for (int c = 0; c < agg->column_count; ++c) {
+        const cdex_field_t* source = &agg->desc->fields[agg->column_fields[c]];
+        for (int k = 0; k < 4; ++k) {
+            // 截断字段名，保留后缀
+            snprintf(names[count], CDEX_FIELD_NAME_LEN, "%.*s%s",
+                     (int)(CDEX_FIELD_NAME_LEN - 1 - strlen(suffixes[k])), source->name, suffixes[k]);
+            fields[count] = *source;
+            fields[count].name = names[count];
+            if (k == 2) {
+                fields[count].type = is_wide_type(source->type) ? CDEX_TYPE_D64 : CDEX_TYPE_F32;
+                fields[count].size = is_wide_type(source->type) ? 8 : 4;
+                fields[count].scale = 0;
+            }
+            count++;
+        }
+    }
+    cdex_status_t status = cdex_descriptor_load(agg->summary_id, fields, count);
+    if (status == CDEX_ERROR_ID_EXISTS && summary_matches(cdex_get_descriptor_by_id(agg->summary_id), fields, count)) {
+        // 重新初始化时沿用之前注册的汇总描述符
+        return CDEX_SUCCESS;
+    }
+    return status;
+}
+
+cdex_status_t cdex_agg_init(cdex_aggregator_t* agg, uint16_t descriptor_id, uint16_t summary_id,
+                            uint64_t field_mask, uint64_t window_ns, uint32_t max_devices,
+                            cdex_agg_emit_fn emit, void* emit_ctx) {
+    if (!agg || window_ns == 0 || max_devices == 0 || max_devices > (1u << 30)) return CDEX_ERROR_INVALID_DATA;
+    memset(agg, 0, sizeof(cdex_aggregator_t));
+    agg->desc = cdex_get_descriptor_by_id(descriptor_id);
+    if (!agg->desc) return CDEX_ERROR_DESCRIPTOR_NOT_FOUND;
+    agg->descriptor_id = descriptor_id;
+    agg->summary_id = summary_id;
+    agg->window_ns = window_ns;
+    agg->emit = emit;
+    agg->emit_ctx = emit_ctx;
+
+    memset(agg->columns, -1, sizeof(agg->columns));
+    for (int i = 0; i < agg->desc->field_count; ++i) {
+        if (field_mask && !((field_mask >> i) & 1)) continue;
+        if (!cdex_type_is_numeric(agg->desc->fields[i].type)) continue;
+        if (agg->column_count >= CDEX_AGG_MAX_COLUMNS) return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
+        agg->columns[i] = (int8_t)agg->column_count;
+        agg->column_fields[agg->column_count++] = (uint8_t)i;
+        agg->field_mask |= 1ULL << i;
+    }
+    if (agg->column_count == 0) return CDEX_ERROR_INVALID_DATA;
+
+    cdex_status_t status = register_summary(agg);
+    if (status != CDEX_SUCCESS) return status;
+
+    uint32_t index_size = 16;
+    while (index_size < max_devices * 2) index_size <<= 1;
+    agg->device_capacity = max_devices;
+    agg->index_mask = index_size - 1;
+    agg->device_keys = (uint32_t*)malloc(max_devices * sizeof(uint32_t));
+    agg->device_index = (uint32_t*)calloc(index_size, sizeof(uint32_t));
+    agg->records = (uint32_t*)calloc(max_devices, sizeof(uint32_t));
+    agg->cells = (cdex_agg_cell_t*)calloc((size_t)max_devices * agg->column_count, sizeof(cdex_agg_cell_t));
+    agg->active = (uint32_t*)malloc(max_devices * sizeof(uint32_t));
+    if (!agg->device_keys || !agg->device_index || !agg->records || !agg->cells || !agg->active) {
+        cdex_agg_free(agg);
+        return CDEX_ERROR_MEMORY_ALLOCATION;
+    }
+    return CDEX_SUCCESS;
+}
+
+void cdex_agg_free(cdex_aggregator_t* agg) {
+    if (!agg) return;
+    free(agg->device_keys);
+    free(agg->device_index);
+    free(agg->records);
+    free(agg->cells);
+    free(agg->active);
+    agg->device_keys = NULL;
+    agg->device_index = NULL;
+    agg->records = NULL;
+    agg->cells = NULL;
+    agg->active = NULL;
+    agg->device_count = 0;
+    agg->active_count = 0;
+}
+
+/**
+ * @brief 查找设备槽位，不存在时分配新槽位
+ * @return 槽位，设备表已满返回-1
+ */
+static int64_t device_slot(cdex_aggregator_t* agg, uint32_t key) {
+    uint32_t pos = (key * 2654435761u) & agg->index_mask;
+    while (agg->device_index[pos]) {
+        uint32_t slot = agg->device_index[pos] - 1;
+        if (agg->device_keys[slot] == key) return slot;
+        pos = (pos + 1) & agg->index_mask;
+    }
+    if (agg->device_count >= agg->device_capacity) return -1;
+    uint32_t slot = agg->device_count++;
+    agg->device_keys[slot] = key;
+    agg->device_index[pos] = slot + 1;
+    return slot;
+}
+
+/**
+ * @brief 按时间戳推进窗口，并返回本次更新使用的设备行
+ * @return 设备行的第一个单元，包被丢弃时返回NULL 并设置 status
+ */
+static cdex_agg_cell_t* begin_update(cdex_aggregator_t* agg, uint32_t device_key, uint64_t timestamp_ns,
+                                     cdex_status_t* status) {
+    *status = CDEX_SUCCESS;
+    if (agg->window_open && timestamp_ns < agg->window_start) {
+        agg->late++;
+        return NULL;
+    }
+    if (agg->window_open && timestamp_ns - agg->window_start >= agg->window_ns) {
+        cdex_agg_flush(agg);
+    }
+    if (!agg->window_open) {
+        agg->window_start = timestamp_ns - timestamp_ns % agg->window_ns;
+        agg->window_open = true;
+    }
+
+    int64_t slot = device_slot(agg, device_key);
+    if (slot < 0) {
+        agg->dropped++;
+        *status = CDEX_ERROR_QUEUE_FULL;
+        return NULL;
+    }
+    if (agg->records[slot]++ == 0) {
+        agg->active[agg->active_count++] = (uint32_t)slot;
+    }
+    return &agg->cells[(size_t)slot * agg->column_count];
+}
+
+static void accumulate(cdex_agg_cell_t* cell, double v) {
+    if (cell->count == 0) {
+        cell->min = v;
+        cell->max = v;
+        cell->sum = 0;
+    } else {
+        if (v < cell->min) cell->min = v;
+        if (v > cell->max) cell->max = v;
+    }
+    cell->sum += v;
+    cell->last = v;
+    cell->count++;
+}
+
+cdex_status_t cdex_agg_update(cdex_aggregator_t* agg, uint32_t device_key, uint64_t timestamp_ns,
+                              const cdex_packet_t* packet) {
+    if (!agg || !agg->cells || !packet) return CDEX_ERROR_INVALID_DATA;
+    if (packet->descriptor_id != agg->descriptor_id) return CDEX_ERROR_INVALID_DATA;
+
+    cdex_status_t status;
+    cdex_agg_cell_t* row = begin_update(agg, device_key, timestamp_ns, &status);
+    if (!row) return status;
+
+    // values 按 bitmap 顺序存放，逐位推进值下标
+    uint64_t bits = packet->bitmap;
+    int value_index = 0;
+    while (bits && value_index < packet->data_count) {
+        int field_index = lowest_set_bit(bits);
+        bits &= bits - 1;
+        int column = agg->columns[field_index];
+        if (column >= 0) {
+            accumulate(&row[column], cdex_value_to_double(agg->desc->fields[field_index].type,
+                                                          &packet->values[value_index]));
+        }
+        value_index++;
+    }
+    return CDEX_SUCCESS;
+}
+
+cdex_status_t cdex_agg_update_frame(cdex_aggregator_t* agg, uint32_t device_key, uint64_t timestamp_ns,
+                                    const uint8_t* buffer, size_t buffer_len) {
+    if (!agg || !agg->cells || !buffer) return CDEX_ERROR_INVALID_DATA;
+    cdex_reader_t reader;
+    cdex_status_t status = cdex_reader_init(&reader, buffer, buffer_len);
+    if (status != CDEX_SUCCESS) return status;
+    if (reader.desc->id != agg->descriptor_id) return CDEX_ERROR_INVALID_DATA;
+
+    // 先读出全部字段再更新，帧中途损坏时不留下半个包的聚合值
+    double values[CDEX_AGG_MAX_COLUMNS];
+    uint64_t bits = reader.bitmap & agg->field_mask;
+    while (bits) {
+        int field_index = lowest_set_bit(bits);
+        bits &= bits - 1;
+        cdex_value_t value;
+        status = cdex_reader_get(&reader, field_index, &value);
+        if (status != CDEX_SUCCESS) return status;
+        values[agg->columns[field_index]] = cdex_value_to_double(agg->desc->fields[field_index].type, &value);
+    }
+
+    cdex_agg_cell_t* row = begin_update(agg, device_key, timestamp_ns, &status);
+    if (!row) return status;
+    bits = reader.bitmap & agg->field_mask;
+    while (bits) {
+        int field_index = lowest_set_bit(bits);
+        bits &= bits - 1;
+        int column = agg->columns[field_index];
+        accumulate(&row[column], values[column]);
+    }
+    return CDEX_SUCCESS;
+}
+
+static bool emit_device(cdex_aggregator_t* agg, uint32_t slot) {
+    cdex_packet_t summary;
+    cdex_packet_init(&summary, agg->summary_id);
+    cdex_value_t value;
+    memset(&value, 0, sizeof(value));
+    value.i64 = agg->device_keys[slot];
+    cdex_packet_push(&summary, 0, value);
+    value.u64 = agg->window_start;
+    cdex_packet_push(&summary, 1, value);
+    value.i64 = agg->records[slot];
+    cdex_packet_push(&summary, 2, value);
+
+    const cdex_agg_cell_t* row = &agg->cells[(size_t)slot * agg->column_count];
+    for (int c = 0; c < agg->column_count; ++c) {
+        const cdex_agg_cell_t* cell = &row[c];
+        if (cell->count == 0) continue;
+        cdex_data_type_t type = agg->desc->fields[agg->column_fields[c]].type;
+        int base = CDEX_AGG_SUMMARY_FIXED + 4 * c;
+        cdex_packet_push(&summary, base, value_from_double(type, cell->min));
+        cdex_packet_push(&summary, base + 1, value_from_double(type, cell->max));
+        cdex_packet_push(&summary, base + 2,
+                         value_from_double(is_wide_type(type) ? CDEX_TYPE_D64 : CDEX_TYPE_F32, cell->sum / cell->count));
+        cdex_packet_push(&summary, base + 3, value_from_double(type, cell->last));
+    }
+
+    uint8_t frame[CDEX_AGG_MAX_FRAME];
+    int len = cdex_pack(&summary, frame, sizeof(frame));
+    if (len <= 0) {
+        agg->emit_failed++;
+        return false;
+    }
+    if (agg->emit) {
+        agg->emit(agg->device_keys[slot], agg->window_start, frame, (size_t)len, agg->emit_ctx);
+    }
+    return true;
+}
+
+int cdex_agg_flush(cdex_aggregator_t* agg) {
+    if (!agg || !agg->cells || !agg->window_open) return 0;
+    int emitted = 0;
+    for (uint32_t i = 0; i < agg->active_count; ++i) {
+        uint32_t slot = agg->active[i];
+        if (emit_device(agg, slot)) emitted++;
+        memset(&agg->cells[(size_t)slot * agg->column_count], 0, agg->column_count * sizeof(cdex_agg_cell_t));
+        agg->records[slot] = 0;
+    }
+    agg->active_count = 0;
+    agg->window_open = false;
+    return emitted;
+}
+
+#endif // CDEX_NO_HEAP
@@ -0,0 +1,123 @@
+#ifndef CDEX_AGG_H
+#define CDEX_AGG_H
+
+#include "cdex.h"
+
+#ifdef CDEX_NO_HEAP
+#error "cdex_agg requires heap allocation and cannot be used with CDEX_NO_HEAP"
+#endif
+
+/*
+ * 按设备、按字段的滚动窗口聚合。
+ *
+ * 每个聚合器对应一个描述符，为选定的数值字段维护 min/max/mean/last。
+ * 聚合状态是按 (设备槽位, 列) 排列的扁平数组，更新时只访问 DataMask 中存在的字段。
+ * 窗口关闭时每个有数据的设备输出一个汇总包，用汇总描述符经 cdex_pack 重新编码：
+ *
+ *   device:num, window_start:u64, count:num,
+ *   <字段>_min, <字段>_max, <字段>_mean, <字段>_last, ...
+ *
+ * min/max/last 沿用源字段的类型和缩放系数，mean 为 f32 (源字段为 8 字节或 num 时为 d64)。
+ * 窗口内没有出现的字段在汇总包中同样不出现。聚合值以 double 保存，
+ * 超过 2^53 的 64 位整数会损失精度。
+ *
+ * 聚合状态按 max_devices 在堆上分配，汇总描述符经 cdex_descriptor_load 注册，
+ * 因此定义 CDEX_NO_HEAP 时不提供本模块。
+ */
+
+#define CDEX_AGG_SUMMARY_FIXED 3 // device, window_start, count
+#define CDEX_AGG_MAX_COLUMNS ((CDEX_MAX_FIELDS - CDEX_AGG_SUMMARY_FIXED) / 4)
+#define CDEX_AGG_MAX_FRAME 1024
+
+/**
+ * @brief 窗口关闭时交付汇总帧的回调
+ * @param device_key 设备标识
+ * @param window_start_ns 窗口起始时间
+ * @param frame 汇总包编码后的 CDEX 帧，回调返回后失效
+ */
+typedef void (*cdex_agg_emit_fn)(uint32_t device_key, uint64_t window_start_ns,
+                                 const uint8_t* frame, size_t frame_len, void* ctx);
+
+/**
+ * @brief 单个设备单个字段在当前窗口内的聚合值
+ */
+typedef struct {
+    double min;
+    double max;
+    double sum;
+    double last;
+    uint32_t count;
+} cdex_agg_cell_t;
+
+/**
+ * @brief 单个描述符的滚动窗口聚合器
+ */
+typedef struct {
+    uint16_t descriptor_id;
+    uint16_t summary_id;
+    const cdex_descriptor_t* desc;
+    uint64_t window_ns;
+    uint64_t window_start;
+    bool window_open;
+    uint64_t field_mask;                          // 参与聚合的字段
+    int column_count;
+    int8_t columns[CDEX_MAX_FIELDS];              // 字段索引 -> 列，不参与聚合为-1
+    uint8_t column_fields[CDEX_AGG_MAX_COLUMNS];  // 列 -> 字段索引
+    uint32_t device_capacity;
+    uint32_t device_count;
+    uint32_t* device_keys;                        // 槽位 -> 设备标识
+    uint32_t* device_index;                       // 开放寻址哈希表，值为槽位 + 1
+    uint32_t index_mask;
+    uint32_t* records;                            // 每个槽位当前窗口的包数
+    cdex_agg_cell_t* cells;                       // device_capacity * column_count
+    uint32_t* active;                             // 当前窗口有数据的槽位
+    uint32_t active_count;
+    cdex_agg_emit_fn emit;
+    void* emit_ctx;
+    uint64_t late;                                // 早于当前窗口而丢弃的包数
+    uint64_t dropped;                             // 设备表已满而丢弃的包数
+    uint64_t emit_failed;                         // 汇总包编码失败而未输出的次数
+} cdex_aggregator_t;
+
+/**
+ * @brief 初始化聚合器，并以 summary_id 注册汇总描述符
+ * @param descriptor_id 被聚合的描述符ID，需已注册
+ * @param summary_id 汇总描述符ID，需未被占用，或已注册为相同的汇总描述符 (例如重新初始化同一聚合器)
+ * @param field_mask 参与聚合的字段，0 表示全部数值字段；非数值字段会被忽略
+ * @param window_ns 窗口长度
+ * @param max_devices 设备数上限
+ * @return 状态码，数值字段超过 CDEX_AGG_MAX_COLUMNS 时返回 CDEX_ERROR_INDEX_OUT_OF_BOUNDS
+ */
+cdex_status_t cdex_agg_init(cdex_aggregator_t* agg, uint16_t descriptor_id, uint16_t summary_id,
+                            uint64_t field_mask, uint64_t window_ns, uint32_t max_devices,
+                            cdex_agg_emit_fn emit, void* emit_ctx);
+
+/**
+ * @brief 释放聚合器，不会输出当前窗口 (需要时先调用 cdex_agg_flush)
+ */
+void cdex_agg_free(cdex_aggregator_t* agg);
+
+/**
+ * @brief 用已解析的数据包更新聚合值
+ *
+ * 时间戳越过当前窗口时先关闭并输出当前窗口；早于当前窗口的包计入 late 并丢弃。
+ * @param device_key 设备标识，例如来源地址的哈希或包中的设备号字段
+ * @return 状态码，设备表已满时返回 CDEX_ERROR_QUEUE_FULL
+ */
+cdex_status_t cdex_agg_update(cdex_aggregator_t* agg, uint32_t device_key, uint64_t timestamp_ns,
+                              const cdex_packet_t* packet);
+
+/**
+ * @brief 直接从字节流更新聚合值，经 cdex_reader_t 按布局表读取字段，不解析整个包
+ * @return 状态码，同 cdex_agg_update，另外可能返回 cdex_reader_init 的错误码
+ */
+cdex_status_t cdex_agg_update_frame(cdex_aggregator_t* agg, uint32_t device_key, uint64_t timestamp_ns,
+                                    const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief 关闭并输出当前窗口
+ * @return 输出的汇总包数，编码失败的设备计入 emit_failed
+ */
+int cdex_agg_flush(cdex_aggregator_t* agg);
+
+#endif // CDEX_AGG_H
@@ -0,0 +1,532 @@
+// 本模块依赖堆内存，CDEX_NO_HEAP 构建中编译为空
+#ifndef CDEX_NO_HEAP
+#include "cdex_capture.h"
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CAPTURE_MAGIC "CDEXCAP1"
+#define INDEX_MAGIC "CDEXIDX1"
+#define TRAILER_MAGIC "CDEXEND1"
+#define CAPTURE_VERSION 1
+#define INDEX_HEADER_SIZE 16
+#define TRAILER_SIZE 16
+
+// 每条记录至少包含描述符ID
+#define MIN_RECORD_SIZE (CDEX_CAPTURE_RECORD_HEADER + 2)
+
+struct cdex_capture_desc_state {
+    cdex_capture_desc_t info;
+    uint32_t* blocks;         // 出现过该描述符的块号，按写出顺序递增
+    uint32_t block_capacity;
+};
+
+static cdex_status_t write_all(int fd, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return CDEX_ERROR_INVALID_DATA;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 截掉 file_offset 之后部分写出的内容，使文件位置回到记录区末尾
+ *
+ * 截断失败时文件位置已不可知，写入端被标记为失败，之后的追加、写出和索引都会被拒绝。
+ */
+static void rewind_to_data_end(cdex_capture_writer_t* writer) {
+    if (ftruncate(writer->fd, (off_t)writer->file_offset) != 0 ||
+        lseek(writer->fd, (off_t)writer->file_offset, SEEK_SET) < 0) {
+        writer->failed = true;
+    }
+}
+
+static bool grow(void** array, uint32_t* capacity, size_t elem_size) {
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 16;
+    void* grown = realloc(*array, new_capacity * elem_size);
+    if (!grown) return false;
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static void release_writer(cdex_capture_writer_t* writer) {
+    for (uint32_t i = 0; i < writer->desc_count; ++i) {
+        free(writer->descs[i].blocks);
+    }
+    free(writer->descs);
+    free(writer->desc_slot);
+    free(writer->blocks);
+    free(writer->block_id_seen);
+    free(writer->block_ids);
+    free(writer->block);
+    if (writer->fd >= 0) close(writer->fd);
+    memset(writer, 0, sizeof(cdex_capture_writer_t));
+    writer->fd = -1;
+}
+
+cdex_status_t cdex_capture_open(cdex_capture_writer_t* writer, const char* path) {
+    if (!writer || !path) return CDEX_ERROR_INVALID_DATA;
+    memset(writer, 0, sizeof(cdex_capture_writer_t));
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) return CDEX_ERROR_INVALID_DATA;
+
+    writer->block = (uint8_t*)malloc(CDEX_CAPTURE_BLOCK_SIZE);
+    writer->block_ids = (uint16_t*)malloc((CDEX_CAPTURE_BLOCK_SIZE / MIN_RECORD_SIZE + 1) * sizeof(uint16_t));
+    writer->block_id_seen = (uint64_t*)calloc(65536 / 64, sizeof(uint64_t));
+    writer->desc_slot = (uint32_t*)calloc(65536, sizeof(uint32_t));
+    if (!writer->block || !writer->block_ids || !writer->block_id_seen || !writer->desc_slot) {
+        release_writer(writer);
+        return CDEX_ERROR_MEMORY_ALLOCATION;
+    }
+
+    cdex_capture_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, 8);
+    header.version = CAPTURE_VERSION;
+    header.header_size = sizeof(cdex_capture_header_t);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    header.created_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+    if (write_all(writer->fd, &header, sizeof(header)) != CDEX_SUCCESS) {
+        release_writer(writer);
+        return CDEX_ERROR_INVALID_DATA;
+    }
+    writer->file_offset = sizeof(header);
+    return CDEX_SUCCESS;
+}
+
+static cdex_capture_desc_state_t* desc_state(cdex_capture_writer_t* writer, uint16_t id) {
+    uint32_t slot = writer->desc_slot[id];
+    if (slot) return &writer->descs[slot - 1];
+
+    if (writer->desc_count == writer->desc_capacity &&
+        !grow((void**)&writer->descs, &writer->desc_capacity, sizeof(cdex_capture_desc_state_t))) {
+        return NULL;
+    }
+    cdex_capture_desc_state_t* state = &writer->descs[writer->desc_count];
+    memset(state, 0, sizeof(cdex_capture_desc_state_t));
+    state->info.descriptor_id = id;
+    writer->desc_slot[id] = ++writer->desc_count;
+    return state;
+}
+
+cdex_status_t cdex_capture_append(cdex_capture_writer_t* writer, uint64_t timestamp_ns,
+                                  const uint8_t* frame, size_t frame_len) {
+    if (!writer || !writer->block || writer->failed || !frame || frame_len < 2) return CDEX_ERROR_INVALID_DATA;
+    size_t record_len = CDEX_CAPTURE_RECORD_HEADER + frame_len;
+    if (record_len > CDEX_CAPTURE_BLOCK_SIZE) return CDEX_ERROR_BUFFER_TOO_SMALL;
+
+    if (writer->block_used + record_len > CDEX_CAPTURE_BLOCK_SIZE) {
+        cdex_status_t status = cdex_capture_flush(writer);
+        if (status != CDEX_SUCCESS) return status;
+    }
+
+    uint16_t id = (uint16_t)(frame[0] | (frame[1] << 8));
+    cdex_capture_desc_state_t* state = desc_state(writer, id);
+    if (!state) return CDEX_ERROR_MEMORY_ALLOCATION;
+
+    uint8_t* p = writer->block + writer->block_used;
+    uint16_t len16 = (uint16_t)frame_len;
+    memcpy(p, &timestamp_ns, 8);
+    memcpy(p + 8, &len16, 2);
+    memcpy(p + CDEX_CAPTURE_RECORD_HEADER, frame, frame_len);
+    writer->block_used += record_len;
+
+    // 多线程接收等场景下时间戳可能乱序，索引记录最小和最大值
+    if (writer->block_records == 0 || timestamp_ns < writer->block_first_ns) writer->block_first_ns = timestamp_ns;
+    if (writer->block_records == 0 || timestamp_ns > writer->block_last_ns) writer->block_last_ns = timestamp_ns;
+    writer->block_records++;
+
+    uint64_t bit = 1ull << (id & 63);
+    if (!(writer->block_id_seen[id >> 6] & bit)) {
+        writer->block_id_seen[id >> 6] |= bit;
+        writer->block_ids[writer->block_id_count++] = id;
+    }
+
+    if (state->info.record_count == 0 || timestamp_ns < state->info.first_ns) state->info.first_ns = timestamp_ns;
+    if (state->info.record_count == 0 || timestamp_ns > state->info.last_ns) state->info.last_ns = timestamp_ns;
+    state->info.record_count++;
+    return CDEX_SUCCESS;
+}
+
+cdex_status_t cdex_capture_flush(cdex_capture_writer_t* writer) {
+    if (!writer || !writer->block || writer->failed) return CDEX_ERROR_INVALID_DATA;
+    if (writer->block_used == 0) return CDEX_SUCCESS;
+
+    if (writer->block_count == writer->block_capacity &&
+        !grow((void**)&writer->blocks, &writer->block_capacity, sizeof(cdex_capture_block_t))) {
+        return CDEX_ERROR_MEMORY_ALLOCATION;
+    }
+    // 先为本块的块号列表预留空间，写文件之后不再有失败路径，索引与数据保持一致
+    for (int i = 0; i < writer->block_id_count; ++i) {
+        cdex_capture_desc_state_t* state = &writer->descs[writer->desc_slot[writer->block_ids[i]] - 1];
+        if (state->info.list_len == state->block_capacity &&
+            !grow((void**)&state->blocks, &state->block_capacity, sizeof(uint32_t))) {
+            return CDEX_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+
+    cdex_status_t status = write_all(writer->fd, writer->block, writer->block_used);
+    if (status != CDEX_SUCCESS) {
+        rewind_to_data_end(writer);
+        return status;
+    }
+
+    uint32_t block_index = writer->block_count++;
+    cdex_capture_block_t* block = &writer->blocks[block_index];
+    block->offset = writer->file_offset;
+    block->first_ns = writer->block_first_ns;
+    block->last_ns = writer->block_last_ns;
+    block->size = (uint32_t)writer->block_used;
+    block->record_count = writer->block_records;
+
+    for (int i = 0; i < writer->block_id_count; ++i) {
+        uint16_t id = writer->block_ids[i];
+        cdex_capture_desc_state_t* state = &writer->descs[writer->desc_slot[id] - 1];
+        state->blocks[state->info.list_len++] = block_index;
+        writer->block_id_seen[id >> 6] &= ~(1ull << (id & 63));
+    }
+
+    writer->file_offset += writer->block_used;
+    writer->block_used = 0;
+    writer->block_records = 0;
+    writer->block_id_count = 0;
+    return CDEX_SUCCESS;
+}
+
+static cdex_status_t write_index(cdex_capture_writer_t* writer) {
+    static const uint8_t zeros[8] = {0};
+    size_t pad = (size_t)((8 - (writer->file_offset & 7)) & 7);
+    cdex_status_t status = write_all(writer->fd, zeros, pad);
+    if (status != CDEX_SUCCESS) return status;
+    uint64_t index_offset = writer->file_offset + pad;
+
+    uint8_t index_header[INDEX_HEADER_SIZE];
+    memcpy(index_header, INDEX_MAGIC, 8);
+    memcpy(index_header + 8, &writer->block_count, 4);
+    memcpy(index_header + 12, &writer->desc_count, 4);
+    status = write_all(writer->fd, index_header, sizeof(index_header));
+    if (status != CDEX_SUCCESS) return status;
+    status = write_all(writer->fd, writer->blocks, writer->block_count * sizeof(cdex_capture_block_t));
+    if (status != CDEX_SUCCESS) return status;
+
+    // desc_slot 按ID顺序遍历即得到按ID排序的描述符表
+    uint32_t list_start = 0;
+    for (uint32_t id = 0; id < 65536; ++id) {
+        if (!writer->desc_slot[id]) continue;
+        cdex_capture_desc_state_t* state = &writer->descs[writer->desc_slot[id] - 1];
+        state->info.list_start = list_start;
+        list_start += state->info.list_len;
+        status = write_all(writer->fd, &state->info, sizeof(cdex_capture_desc_t));
+        if (status != CDEX_SUCCESS) return status;
+    }
+    for (uint32_t id = 0; id < 65536; ++id) {
+        if (!writer->desc_slot[id]) continue;
+        cdex_capture_desc_state_t* state = &writer->descs[writer->desc_slot[id] - 1];
+        status = write_all(writer->fd, state->blocks, state->info.list_len * sizeof(uint32_t));
+        if (status != CDEX_SUCCESS) return status;
+    }
+    size_t lists_size = list_start * sizeof(uint32_t);
+    status = write_all(writer->fd, zeros, (8 - (lists_size & 7)) & 7);
+    if (status != CDEX_SUCCESS) return status;
+
+    uint8_t trailer[TRAILER_SIZE];
+    memcpy(trailer, &index_offset, 8);
+    memcpy(trailer + 8, TRAILER_MAGIC, 8);
+    return write_all(writer->fd, trailer, sizeof(trailer));
+}
+
+cdex_status_t cdex_capture_close(cdex_capture_writer_t* writer) {
+    if (!writer || !writer->block) return CDEX_ERROR_INVALID_DATA;
+    cdex_status_t status = cdex_capture_flush(writer);
+    if (status == CDEX_SUCCESS) {
+        status = write_index(writer);
+        if (status != CDEX_SUCCESS) rewind_to_data_end(writer);
+    }
+    // 写索引失败时去掉不完整的索引，文件仍可按无索引方式读取
+    release_writer(writer);
+    return status;
+}
+
+// --- 读取端 ---
+
+static bool load_index(cdex_capture_reader_t* reader) {
+    size_t size = reader->size;
+    if (size < sizeof(cdex_capture_header_t) + INDEX_HEADER_SIZE + TRAILER_SIZE) return false;
+    const uint8_t* trailer = reader->base + size - TRAILER_SIZE;
+    if (memcmp(trailer + 8, TRAILER_MAGIC, 8) != 0) return false;
+
+    uint64_t index_offset;
+    memcpy(&index_offset, trailer, 8);
+    if (index_offset < sizeof(cdex_capture_header_t) || (index_offset & 7) ||
+        index_offset + INDEX_HEADER_SIZE > size - TRAILER_SIZE) {
+        return false;
+    }
+    const uint8_t* index = reader->base + index_offset;
+    if (memcmp(index, INDEX_MAGIC, 8) != 0) return false;
+
+    uint32_t block_count, desc_count;
+    memcpy(&block_count, index + 8, 4);
+    memcpy(&desc_count, index + 12, 4);
+    uint64_t available = size - TRAILER_SIZE - index_offset - INDEX_HEADER_SIZE;
+    uint64_t tables = (uint64_t)block_count * sizeof(cdex_capture_block_t) +
+                      (uint64_t)desc_count * sizeof(cdex_capture_desc_t);
+    if (tables > available) return false;
+
+    const cdex_capture_block_t* blocks = (const cdex_capture_block_t*)(index + INDEX_HEADER_SIZE);
+    const cdex_capture_desc_t* descs = (const cdex_capture_desc_t*)(blocks + block_count);
+    const uint32_t* lists = (const uint32_t*)(descs + desc_count);
+    uint64_t list_total = (available - tables) / sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < block_count; ++i) {
+        if (blocks[i].offset < sizeof(cdex_capture_header_t) || blocks[i].offset > index_offset ||
+            blocks[i].size > index_offset - blocks[i].offset) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < desc_count; ++i) {
+        if ((uint64_t)descs[i].list_start + descs[i].list_len > list_total) return false;
+        if (i > 0 && descs[i].descriptor_id <= descs[i - 1].descriptor_id) return false;
+        for (uint32_t k = 0; k < descs[i].list_len; ++k) {
+            if (lists[descs[i].list_start + k] >= block_count) return false;
+        }
+    }
+
+    reader->indexed = true;
+    reader->data_end = (size_t)index_offset;
+    reader->blocks = blocks;
+    reader->block_count = block_count;
+    reader->descs = descs;
+    reader->desc_count = desc_count;
+    reader->block_lists = lists;
+    return true;
+}
+
+cdex_status_t cdex_capture_reader_open(cdex_capture_reader_t* reader, const char* path) {
+    if (!reader || !path) return CDEX_ERROR_INVALID_DATA;
+    memset(reader, 0, sizeof(cdex_capture_reader_t));
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) return CDEX_ERROR_INVALID_DATA;
+
+    struct stat st;
+    if (fstat(reader->fd, &st) != 0 || (size_t)st.st_size < sizeof(cdex_capture_header_t)) {
+        close(reader->fd);
+        reader->fd = -1;
+        return CDEX_ERROR_INVALID_DATA;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+    if (base == MAP_FAILED) {
+        close(reader->fd);
+        reader->fd = -1;
+        return CDEX_ERROR_MEMORY_ALLOCATION;
+    }
+    reader->base = (const uint8_t*)base;
+    reader->size = (size_t)st.st_size;
+
+    cdex_capture_header_t header;
+    memcpy(&header, reader->base, sizeof(header));
+    if (memcmp(header.magic, CAPTURE_MAGIC, 8) != 0 || header.version != CAPTURE_VERSION ||
+        header.header_size != sizeof(cdex_capture_header_t)) {
+        cdex_capture_reader_close(reader);
+        return CDEX_ERROR_INVALID_DATA;
+    }
+    // 回放通常从头读到尾
+    madvise(base, reader->size, MADV_SEQUENTIAL);
+
+    if (!load_index(reader)) {
+        reader->data_end = reader->size;
+    }
+    return CDEX_SUCCESS;
+}
+
+void cdex_capture_reader_close(cdex_capture_reader_t* reader) {
+    if (!reader) return;
+    if (reader->base) munmap((void*)reader->base, reader->size);
+    if (reader->fd >= 0) close(reader->fd);
+    memset(reader, 0, sizeof(cdex_capture_reader_t));
+    reader->fd = -1;
+}
+
+/**
+ * @brief 读出 [*offset, end) 范围内的一条记录，记录不完整时返回 false
+ */
+static bool read_record(const cdex_capture_reader_t* reader, size_t* offset, size_t end,
+                        uint64_t* timestamp_ns, const uint8_t** frame, size_t* frame_len) {
+    if (end - *offset < CDEX_CAPTURE_RECORD_HEADER) return false;
+    const uint8_t* p = reader->base + *offset;
+    // 缺少文件尾但索引已部分写出时，在索引头处停止。索引头前有 0-7 字节的零填充，按8字节对齐
+    if (!reader->indexed) {
+        size_t pad = (8 - (*offset & 7)) & 7;
+        if (end - *offset >= pad + 8 && memcmp(p + pad, INDEX_MAGIC, 8) == 0) {
+            size_t i = 0;
+            while (i < pad && p[i] == 0) i++;
+            if (i == pad) return false;
+        }
+    }
+    uint16_t len16;
+    memcpy(timestamp_ns, p, 8);
+    memcpy(&len16, p + 8, 2);
+    // 长度为0说明到了无索引文件末尾的填充区
+    if (len16 < 2 || end - *offset - CDEX_CAPTURE_RECORD_HEADER < len16) return false;
+    *frame = p + CDEX_CAPTURE_RECORD_HEADER;
+    *frame_len = len16;
+    *offset += CDEX_CAPTURE_RECORD_HEADER + len16;
+    return true;
+}
+
+bool cdex_capture_time_range(const cdex_capture_reader_t* reader, uint64_t* first_ns, uint64_t* last_ns) {
+    if (!reader || !reader->base) return false;
+    uint64_t first = UINT64_MAX, last = 0;
+    bool found = false;
+    if (reader->indexed) {
+        for (uint32_t i = 0; i < reader->block_count; ++i) {
+            if (reader->blocks[i].record_count == 0) continue;
+            if (reader->blocks[i].first_ns < first) first = reader->blocks[i].first_ns;
+            if (reader->blocks[i].last_ns > last) last = reader->blocks[i].last_ns;
+            found = true;
+        }
+    } else {
+        size_t offset = sizeof(cdex_capture_header_t);
+        uint64_t ts;
+        const uint8_t* frame;
+        size_t len;
+        while (read_record(reader, &offset, reader->data_end, &ts, &frame, &len)) {
+            if (ts < first) first = ts;
+            if (ts > last) last = ts;
+            found = true;
+        }
+    }
+    if (found) {
+        if (first_ns) *first_ns = first;
+        if (last_ns) *last_ns = last;
+    }
+    return found;
+}
+
+const cdex_capture_desc_t* cdex_capture_find_desc(const cdex_capture_reader_t* reader, uint16_t descriptor_id) {
+    if (!reader || !reader->indexed) return NULL;
+    uint32_t lo = 0, hi = reader->desc_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        uint16_t id = reader->descs[mid].descriptor_id;
+        if (id == descriptor_id) return &reader->descs[mid];
+        if (id < descriptor_id) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+cdex_status_t cdex_capture_cursor_init(cdex_capture_cursor_t* cursor, const cdex_capture_reader_t* reader,
+                                       const uint16_t* ids, int id_count, uint64_t start_ns, uint64_t end_ns) {
+    if (!cursor || !reader || !reader->base) return CDEX_ERROR_INVALID_DATA;
+    if (!ids) id_count = 0;
+    if (id_count < 0 || id_count > CDEX_CAPTURE_MAX_QUERY_IDS) return CDEX_ERROR_INDEX_OUT_OF_BOUNDS;
+
+    memset(cursor, 0, sizeof(cdex_capture_cursor_t));
+    cursor->reader = reader;
+    cursor->id_count = id_count;
+    for (int i = 0; i < id_count; ++i) {
+        cursor->ids[i] = ids[i];
+        cursor->descs[i] = cdex_capture_find_desc(reader, ids[i]);
+    }
+    cursor->start_ns = start_ns;
+    cursor->end_ns = end_ns ? end_ns : UINT64_MAX;
+
+    if (!reader->indexed) {
+        // 无索引时把整个记录区当作一个块顺序扫描
+        cursor->offset = sizeof(cdex_capture_header_t);
+        cursor->block_end = reader->data_end;
+    }
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 选出下一个可能包含目标记录的块，按ID过滤时合并各ID的块号列表
+ */
+static bool next_block(cdex_capture_cursor_t* cursor) {
+    const cdex_capture_reader_t* reader = cursor->reader;
+    if (!reader->indexed) return false;
+
+    while (true) {
+        uint32_t b = UINT32_MAX;
+        if (cursor->id_count == 0) {
+            if (cursor->next_block < reader->block_count) b = cursor->next_block;
+        } else {
+            for (int i = 0; i < cursor->id_count; ++i) {
+                const cdex_capture_desc_t* desc = cursor->descs[i];
+                if (!desc) continue;
+                while (cursor->list_pos[i] < desc->list_len &&
+                       reader->block_lists[desc->list_start + cursor->list_pos[i]] < cursor->next_block) {
+                    cursor->list_pos[i]++;
+                }
+                if (cursor->list_pos[i] < desc->list_len) {
+                    uint32_t candidate = reader->block_lists[desc->list_start + cursor->list_pos[i]];
+                    if (candidate < b) b = candidate;
+                }
+            }
+        }
+        if (b == UINT32_MAX) return false;
+        cursor->next_block = b + 1;
+
+        const cdex_capture_block_t* block = &reader->blocks[b];
+        if (block->last_ns < cursor->start_ns || block->first_ns > cursor->end_ns) continue;
+        cursor->offset = (size_t)block->offset;
+        cursor->block_end = (size_t)(block->offset + block->size);
+        return true;
+    }
+}
+
+static bool id_selected(const cdex_capture_cursor_t* cursor, const uint8_t* frame) {
+    if (cursor->id_count == 0) return true;
+    uint16_t id = (uint16_t)(frame[0] | (frame[1] << 8));
+    for (int i = 0; i < cursor->id_count; ++i) {
+        if (cursor->ids[i] == id) return true;
+    }
+    return false;
+}
+
+bool cdex_capture_next(cdex_capture_cursor_t* cursor, uint64_t* timestamp_ns, const uint8_t** frame, size_t* frame_len) {
+    if (!cursor || !cursor->reader) return false;
+    uint64_t ts;
+    const uint8_t* data;
+    size_t len;
+    while (true) {
+        if (!read_record(cursor->reader, &cursor->offset, cursor->block_end, &ts, &data, &len)) {
+            if (!next_block(cursor)) {
+                cursor->offset = cursor->block_end;
+                return false;
+            }
+            continue;
+        }
+        if (ts < cursor->start_ns || ts > cursor->end_ns || !id_selected(cursor, data)) continue;
+        if (timestamp_ns) *timestamp_ns = ts;
+        if (frame) *frame = data;
+        if (frame_len) *frame_len = len;
+        return true;
+    }
+}
+
+int cdex_capture_next_batch(cdex_capture_cursor_t* cursor, uint64_t* timestamps, const uint8_t** frames,
+                            size_t* lens, int max_count) {
+    if (!cursor || !frames || !lens) return 0;
+    int count = 0;
+    while (count < max_count &&
+           cdex_capture_next(cursor, timestamps ? &timestamps[count] : NULL, &frames[count], &lens[count])) {
+        count++;
+    }
+    return count;
+}
+
+#endif // CDEX_NO_HEAP
@@ -0,0 +1,184 @@
+#ifndef CDEX_CAPTURE_H
+#define CDEX_CAPTURE_H
+
+#include "cdex.h"
+
+#ifdef CDEX_NO_HEAP
+#error "cdex_capture requires heap allocation and cannot be used with CDEX_NO_HEAP"
+#endif
+
+/*
+ * 抓包文件格式 (小端)：
+ *
+ * | 文件头 (32) | 数据块 ... | 索引 | 文件尾 (16) |
+ *
+ * 数据块由连续的记录组成，每条记录为 | 时间戳 ns (8) | 帧长度 (2) | CDEX 帧 |，
+ * 写入端按块批量写出。关闭文件时写入索引：块表 (偏移、记录数、时间范围)、
+ * 按描述符ID排序的描述符表，以及每个描述符出现过的块号列表。
+ * 没有正常关闭的文件缺少索引和文件尾，读取端按记录顺序扫描，仍可完整读出。
+ *
+ * 写入端的块缓冲和索引表在堆上分配，读取端通过 mmap 映射文件，
+ * 因此定义 CDEX_NO_HEAP 时不提供本模块。
+ */
+
+#define CDEX_CAPTURE_BLOCK_SIZE (64 * 1024) // 写入端每次批量写出的字节数
+#define CDEX_CAPTURE_MAX_QUERY_IDS 16
+#define CDEX_CAPTURE_RECORD_HEADER 10
+
+typedef struct {
+    char magic[8];          // "CDEXCAP1"
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t reserved;
+    uint64_t created_ns;    // 创建时的墙上时间
+    uint64_t reserved2;
+} cdex_capture_header_t;
+
+typedef struct {
+    uint64_t offset;        // 块在文件中的偏移
+    uint64_t first_ns;      // 块内最小时间戳
+    uint64_t last_ns;       // 块内最大时间戳
+    uint32_t size;          // 块的字节数
+    uint32_t record_count;
+} cdex_capture_block_t;
+
+typedef struct {
+    uint16_t descriptor_id;
+    uint16_t reserved;
+    uint32_t record_count;
+    uint32_t list_start;    // 在块号列表中的起始位置
+    uint32_t list_len;      // 出现过该描述符的块数
+    uint64_t first_ns;      // 该描述符记录的最小时间戳
+    uint64_t last_ns;       // 该描述符记录的最大时间戳
+} cdex_capture_desc_t;
+
+typedef struct cdex_capture_desc_state cdex_capture_desc_state_t;
+
+/**
+ * @brief 抓包写入端，记录先缓存在块缓冲中，块满时一次写出
+ */
+typedef struct {
+    int fd;
+    uint64_t file_offset;
+    uint8_t* block;               // CDEX_CAPTURE_BLOCK_SIZE 字节
+    size_t block_used;
+    uint32_t block_records;
+    uint64_t block_first_ns;      // 当前块的最小时间戳
+    uint64_t block_last_ns;       // 当前块的最大时间戳
+    uint16_t* block_ids;          // 当前块中出现过的描述符ID
+    int block_id_count;
+    uint64_t* block_id_seen;      // 65536 位的位图
+    cdex_capture_block_t* blocks;
+    uint32_t block_count;
+    uint32_t block_capacity;
+    uint32_t* desc_slot;          // 描述符ID -> descs 下标 + 1
+    cdex_capture_desc_state_t* descs;
+    uint32_t desc_count;
+    uint32_t desc_capacity;
+    bool failed;                  // 写出失败且无法截断回 file_offset，不再接受写入
+} cdex_capture_writer_t;
+
+/**
+ * @brief 抓包读取端，整个文件以只读方式 mmap，读出的帧直接指向映射区
+ */
+typedef struct {
+    int fd;
+    const uint8_t* base;
+    size_t size;
+    bool indexed;                        // 文件是否带有索引
+    size_t data_end;                     // 记录区的结束偏移
+    const cdex_capture_block_t* blocks;  // 无索引时为NULL
+    uint32_t block_count;
+    const cdex_capture_desc_t* descs;
+    uint32_t desc_count;
+    const uint32_t* block_lists;
+} cdex_capture_reader_t;
+
+/**
+ * @brief 按描述符ID和时间范围遍历记录的游标
+ */
+typedef struct {
+    const cdex_capture_reader_t* reader;
+    int id_count;                                   // 为0时不按ID过滤
+    uint16_t ids[CDEX_CAPTURE_MAX_QUERY_IDS];
+    const cdex_capture_desc_t* descs[CDEX_CAPTURE_MAX_QUERY_IDS]; // 索引中的表项，文件不含该ID时为NULL
+    uint32_t list_pos[CDEX_CAPTURE_MAX_QUERY_IDS];  // 每个ID在其块号列表中的位置
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint32_t next_block;
+    size_t offset;
+    size_t block_end;
+} cdex_capture_cursor_t;
+
+/**
+ * @brief 创建抓包文件，已存在的文件会被截断
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_capture_open(cdex_capture_writer_t* writer, const char* path);
+
+/**
+ * @brief 追加一帧
+ * @param timestamp_ns 接收时间 (建议使用 CLOCK_REALTIME)。记录按追加顺序保存，时间戳允许乱序，
+ *        索引按块记录最小和最大时间戳，按时间查询时不会漏掉乱序的记录
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_capture_append(cdex_capture_writer_t* writer, uint64_t timestamp_ns,
+                                  const uint8_t* frame, size_t frame_len);
+
+/**
+ * @brief 把缓存中的记录写出到文件
+ * @note 写出失败时文件被截断回写出之前的位置，缓存中的记录保留，可以稍后重试
+ */
+cdex_status_t cdex_capture_flush(cdex_capture_writer_t* writer);
+
+/**
+ * @brief 写出剩余记录、索引和文件尾，并释放写入端
+ */
+cdex_status_t cdex_capture_close(cdex_capture_writer_t* writer);
+
+/**
+ * @brief 以 mmap 方式打开抓包文件
+ * @return 状态码，不是抓包文件时返回 CDEX_ERROR_INVALID_DATA
+ */
+cdex_status_t cdex_capture_reader_open(cdex_capture_reader_t* reader, const char* path);
+
+/**
+ * @brief 解除映射并关闭文件，之前读出的帧指针随之失效
+ */
+void cdex_capture_reader_close(cdex_capture_reader_t* reader);
+
+/**
+ * @brief 查询抓包文件中最早和最晚的记录时间戳，没有记录时返回 false
+ */
+bool cdex_capture_time_range(const cdex_capture_reader_t* reader, uint64_t* first_ns, uint64_t* last_ns);
+
+/**
+ * @brief 查找描述符统计信息，文件没有索引或不含该ID时返回NULL
+ */
+const cdex_capture_desc_t* cdex_capture_find_desc(const cdex_capture_reader_t* reader, uint16_t descriptor_id);
+
+/**
+ * @brief 初始化游标
+ * @param ids 要保留的描述符ID，为NULL或 id_count 为0时保留全部
+ * @param start_ns 起始时间 (含)，0 表示不限
+ * @param end_ns 结束时间 (含)，0 表示不限
+ * @return 状态码，ID数量超过 CDEX_CAPTURE_MAX_QUERY_IDS 时返回 CDEX_ERROR_INDEX_OUT_OF_BOUNDS
+ */
+cdex_status_t cdex_capture_cursor_init(cdex_capture_cursor_t* cursor, const cdex_capture_reader_t* reader,
+                                       const uint16_t* ids, int id_count, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief 读出下一条满足条件的记录，帧指向映射区，不拷贝
+ * @return 有记录时返回 true
+ */
+bool cdex_capture_next(cdex_capture_cursor_t* cursor, uint64_t* timestamp_ns, const uint8_t** frame, size_t* frame_len);
+
+/**
+ * @brief 批量读出记录，frames/lens 可直接传给 cdex_filter_match_batch 等批量接口
+ * @param timestamps 可为NULL
+ * @return 读出的记录数，为0表示已经读完
+ */
+int cdex_capture_next_batch(cdex_capture_cursor_t* cursor, uint64_t* timestamps, const uint8_t** frames,
+                            size_t* lens, int max_count);
+
+#endif // CDEX_CAPTURE_H
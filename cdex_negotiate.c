@@ -0,0 +1,282 @@
+#include "cdex_negotiate.h"
+#include <string.h>
+
+static cdex_nego_pending_t* find_pending(cdex_negotiator_t* nego, uint16_t id) {
+    for (int i = 0; i < CDEX_NEGO_MAX_PENDING_IDS; ++i) {
+        if (nego->pending[i].in_use && nego->pending[i].descriptor_id == id) {
+            return &nego->pending[i];
+        }
+    }
+    return NULL;
+}
+
+static cdex_nego_pending_t* alloc_pending(cdex_negotiator_t* nego, uint16_t id) {
+    for (int i = 0; i < CDEX_NEGO_MAX_PENDING_IDS; ++i) {
+        cdex_nego_pending_t* slot = &nego->pending[i];
+        if (!slot->in_use) {
+            slot->in_use = true;
+            slot->requested = false;
+            slot->retries = 0;
+            slot->descriptor_id = id;
+            slot->head = 0;
+            slot->count = 0;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static void send_request(cdex_negotiator_t* nego, cdex_nego_pending_t* slot) {
+    if (!nego->transport.request) return;
+    // 请求失败时保持未请求状态，下一帧或 cdex_nego_retry 会再次尝试
+    slot->requested = nego->transport.request(slot->descriptor_id, nego->transport.ctx) == CDEX_SUCCESS;
+}
+
+static void deliver_packet(cdex_negotiator_t* nego, cdex_packet_t* packet) {
+    if (nego->deliver) {
+        nego->deliver(packet, nego->deliver_ctx);
+    }
+    cdex_free_packet_memory(packet);
+}
+
+void cdex_nego_init(cdex_negotiator_t* nego, const cdex_nego_transport_t* transport,
+                    cdex_nego_deliver_fn deliver, void* deliver_ctx) {
+    if (!nego) return;
+    memset(nego, 0, sizeof(cdex_negotiator_t));
+    if (transport) {
+        nego->transport = *transport;
+    }
+    nego->deliver = deliver;
+    nego->deliver_ctx = deliver_ctx;
+    nego->max_retries = CDEX_NEGO_MAX_RETRIES;
+}
+
+cdex_status_t cdex_nego_submit(cdex_negotiator_t* nego, const uint8_t* buffer, size_t buffer_len) {
+    return cdex_nego_submit_from(nego, buffer, buffer_len, 0);
+}
+
+cdex_status_t cdex_nego_submit_from(cdex_negotiator_t* nego, const uint8_t* buffer, size_t buffer_len,
+                                    uint64_t source) {
+    if (!nego || !buffer) return CDEX_ERROR_INVALID_DATA;
+
+    cdex_packet_t packet;
+    cdex_status_t status = cdex_parse(buffer, buffer_len, &packet);
+    if (status == CDEX_SUCCESS) {
+        // 描述符可能已通过其它途径注册，先交付暂存帧以保持顺序
+        cdex_nego_drain(nego, packet.descriptor_id);
+        deliver_packet(nego, &packet);
+        return CDEX_SUCCESS;
+    }
+    if (status != CDEX_ERROR_DESCRIPTOR_NOT_FOUND) {
+        // 字段解码失败时可能已分配了部分 str/bin
+        cdex_free_packet_memory(&packet);
+        return status;
+    }
+    if (buffer_len > CDEX_NEGO_MAX_FRAME_LEN) {
+        nego->oversized++;
+        return CDEX_ERROR_BUFFER_TOO_SMALL;
+    }
+
+    // cdex_parse 已校验过 CRC，ID 可信
+    uint16_t id = packet.descriptor_id;
+    cdex_nego_pending_t* slot = find_pending(nego, id);
+    if (!slot) {
+        slot = alloc_pending(nego, id);
+        if (!slot) {
+            nego->dropped++;
+            return CDEX_ERROR_QUEUE_FULL;
+        }
+    }
+    if (slot->count >= CDEX_NEGO_QUEUE_DEPTH) {
+        nego->dropped++;
+        return CDEX_ERROR_QUEUE_FULL;
+    }
+
+    int tail = (slot->head + slot->count) % CDEX_NEGO_QUEUE_DEPTH;
+    memcpy(slot->frames[tail], buffer, buffer_len);
+    slot->lens[tail] = (uint16_t)buffer_len;
+    slot->sources[tail] = source;
+    slot->count++;
+
+    if (!slot->requested) {
+        send_request(nego, slot);
+    }
+    return CDEX_PENDING_DESCRIPTOR;
+}
+
+int cdex_nego_drain(cdex_negotiator_t* nego, uint16_t id) {
+    if (!nego) return 0;
+    cdex_nego_pending_t* slot = find_pending(nego, id);
+    if (!slot || !cdex_get_descriptor_by_id(id)) return 0;
+
+    int delivered = 0;
+    while (slot->count > 0) {
+        cdex_packet_t packet;
+        if (cdex_parse(slot->frames[slot->head], slot->lens[slot->head], &packet) == CDEX_SUCCESS) {
+            deliver_packet(nego, &packet);
+            delivered++;
+        } else {
+            // 与新描述符不匹配的帧无法恢复，丢弃
+            cdex_free_packet_memory(&packet);
+            nego->rejected++;
+        }
+        slot->head = (slot->head + 1) % CDEX_NEGO_QUEUE_DEPTH;
+        slot->count--;
+    }
+    slot->in_use = false;
+    return delivered;
+}
+
+int cdex_nego_drain_raw(cdex_negotiator_t* nego, uint16_t id, cdex_nego_raw_fn fn, void* ctx) {
+    if (!nego || !fn) return 0;
+    cdex_nego_pending_t* slot = find_pending(nego, id);
+    if (!slot) return 0;
+
+    int delivered = 0;
+    while (slot->count > 0) {
+        fn(slot->frames[slot->head], slot->lens[slot->head], slot->sources[slot->head], ctx);
+        delivered++;
+        slot->head = (slot->head + 1) % CDEX_NEGO_QUEUE_DEPTH;
+        slot->count--;
+    }
+    slot->in_use = false;
+    return delivered;
+}
+
+cdex_status_t cdex_nego_register(cdex_negotiator_t* nego, uint16_t id, const char* descriptor_string) {
+    if (!nego || !descriptor_string) return CDEX_ERROR_INVALID_DATA;
+    cdex_status_t status = cdex_descriptor_register(id, descriptor_string);
+    if (status == CDEX_SUCCESS || status == CDEX_ERROR_ID_EXISTS) {
+        cdex_nego_drain(nego, id);
+    }
+    return status;
+}
+
+int cdex_nego_retry(cdex_negotiator_t* nego) {
+    if (!nego) return 0;
+    int sent = 0;
+    for (int i = 0; i < CDEX_NEGO_MAX_PENDING_IDS; ++i) {
+        cdex_nego_pending_t* slot = &nego->pending[i];
+        if (!slot->in_use) continue;
+        if (slot->retries >= nego->max_retries) {
+            // 发送方迟迟不应答，释放队列以免长期占用有限的槽位
+            nego->expired += slot->count;
+            slot->in_use = false;
+            continue;
+        }
+        slot->retries++;
+        send_request(nego, slot);
+        if (slot->requested) sent++;
+    }
+    return sent;
+}
+
+int cdex_nego_cancel(cdex_negotiator_t* nego, uint16_t id) {
+    if (!nego) return 0;
+    cdex_nego_pending_t* slot = find_pending(nego, id);
+    if (!slot) return 0;
+    int discarded = slot->count;
+    nego->expired += (uint32_t)discarded;
+    slot->in_use = false;
+    return discarded;
+}
+
+int cdex_nego_pending_count(const cdex_negotiator_t* nego, uint16_t id) {
+    if (!nego) return 0;
+    for (int i = 0; i < CDEX_NEGO_MAX_PENDING_IDS; ++i) {
+        if (nego->pending[i].in_use && nego->pending[i].descriptor_id == id) {
+            return nego->pending[i].count;
+        }
+    }
+    return 0;
+}
+
+// --- 回环传输 ---
+
+static cdex_status_t loopback_request(uint16_t descriptor_id, void* ctx) {
+    cdex_nego_loopback_t* loopback = (cdex_nego_loopback_t*)ctx;
+    loopback->requests++;
+    if (loopback->outbox_count >= CDEX_NEGO_LOOPBACK_MAX) return CDEX_ERROR_QUEUE_FULL;
+    loopback->outbox[loopback->outbox_count++] = descriptor_id;
+    return CDEX_SUCCESS;
+}
+
+void cdex_nego_loopback_init(cdex_nego_loopback_t* loopback, cdex_nego_transport_t* transport) {
+    if (!loopback) return;
+    memset(loopback, 0, sizeof(cdex_nego_loopback_t));
+    if (transport) {
+        transport->request = loopback_request;
+        transport->ctx = loopback;
+    }
+}
+
+cdex_status_t cdex_nego_loopback_add(cdex_nego_loopback_t* loopback, uint16_t id, const char* descriptor_string) {
+    if (!loopback || !descriptor_string) return CDEX_ERROR_INVALID_DATA;
+    if (loopback->known_count >= CDEX_NEGO_LOOPBACK_MAX) return CDEX_ERROR_QUEUE_FULL;
+    loopback->known_ids[loopback->known_count] = id;
+    loopback->known_strings[loopback->known_count] = descriptor_string;
+    loopback->known_count++;
+    return CDEX_SUCCESS;
+}
+
+int cdex_nego_loopback_pump(cdex_nego_loopback_t* loopback, cdex_negotiator_t* nego) {
+    if (!loopback || !nego) return 0;
+    // 交付回调可能再次提交未知帧并追加请求，只处理调用时已积压的部分
+    int pending = loopback->outbox_count;
+    int answered = 0;
+    for (int i = 0; i < pending; ++i) {
+        for (int k = 0; k < loopback->known_count; ++k) {
+            if (loopback->known_ids[k] == loopback->outbox[i]) {
+                cdex_nego_register(nego, loopback->known_ids[k], loopback->known_strings[k]);
+                answered++;
+                break;
+            }
+        }
+    }
+    loopback->outbox_count -= pending;
+    memmove(loopback->outbox, loopback->outbox + pending, loopback->outbox_count * sizeof(loopback->outbox[0]));
+    return answered;
+}
+
+// --- 控制消息 ---
+
+bool cdex_nego_is_control(const uint8_t* buffer, size_t buffer_len) {
+    return buffer && buffer_len >= 5 && buffer[0] == 0xFF && buffer[1] == 0xFF;
+}
+
+int cdex_nego_encode_control(cdex_nego_op_t op, uint16_t id, const char* descriptor_string,
+                             uint8_t* buffer, size_t buffer_size) {
+    if (!buffer) return -1;
+    size_t str_len = 0;
+    if (op == CDEX_NEGO_OP_DESCRIPTOR) {
+        if (!descriptor_string) return -1;
+        str_len = strlen(descriptor_string) + 1;
+    }
+    if (5 + str_len > buffer_size) return -1;
+    buffer[0] = 0xFF;
+    buffer[1] = 0xFF;
+    buffer[2] = (uint8_t)op;
+    buffer[3] = (uint8_t)(id & 0xFF);
+    buffer[4] = (uint8_t)(id >> 8);
+    if (str_len) memcpy(buffer + 5, descriptor_string, str_len);
+    return (int)(5 + str_len);
+}
+
+cdex_status_t cdex_nego_decode_control(const uint8_t* buffer, size_t buffer_len, cdex_nego_op_t* op,
+                                       uint16_t* id, const char** descriptor_string) {
+    if (!cdex_nego_is_control(buffer, buffer_len) || !op || !id) return CDEX_ERROR_INVALID_PACKET;
+    *op = (cdex_nego_op_t)buffer[2];
+    *id = (uint16_t)(buffer[3] | (buffer[4] << 8));
+    if (descriptor_string) *descriptor_string = NULL;
+    switch (*op) {
+        case CDEX_NEGO_OP_REQUEST:
+        case CDEX_NEGO_OP_ACK:
+            return CDEX_SUCCESS;
+        case CDEX_NEGO_OP_DESCRIPTOR:
+            if (buffer_len < 7 || buffer[buffer_len - 1] != '\0') return CDEX_ERROR_INVALID_DATA;
+            if (descriptor_string) *descriptor_string = (const char*)(buffer + 5);
+            return CDEX_SUCCESS;
+        default:
+            return CDEX_ERROR_INVALID_PACKET;
+    }
+}
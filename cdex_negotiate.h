@@ -0,0 +1,199 @@
+#ifndef CDEX_NEGOTIATE_H
+#define CDEX_NEGOTIATE_H
+
+#include "cdex.h"
+
+#define CDEX_NEGO_MAX_PENDING_IDS 8
+#define CDEX_NEGO_QUEUE_DEPTH 16
+#define CDEX_NEGO_MAX_FRAME_LEN 256
+#define CDEX_NEGO_MAX_RETRIES 5 // cdex_nego_retry 的默认重试上限，超过后丢弃该ID的暂存帧
+
+/**
+ * @brief 向发送方请求描述符的回调
+ * @param descriptor_id 未知的描述符ID
+ * @param ctx 传输层上下文
+ * @return 状态码 (CDEX_SUCCESS 表示请求已发出)
+ */
+typedef cdex_status_t (*cdex_nego_request_fn)(uint16_t descriptor_id, void* ctx);
+
+/**
+ * @brief 交付已解析数据包的回调，回调返回后 packet 中的动态内存会被释放
+ */
+typedef void (*cdex_nego_deliver_fn)(const cdex_packet_t* packet, void* ctx);
+
+/**
+ * @brief 交付暂存帧原始字节的回调，用于调用者自行解析 (例如按来源使用会话字典)
+ * @param source 提交时传入的来源标识
+ */
+typedef void (*cdex_nego_raw_fn)(const uint8_t* frame, size_t frame_len, uint64_t source, void* ctx);
+
+/**
+ * @brief 可插拔的传输层
+ */
+typedef struct {
+    cdex_nego_request_fn request;
+    void* ctx;
+} cdex_nego_transport_t;
+
+/**
+ * @brief 单个未知描述符ID的待处理帧队列 (环形缓冲)
+ */
+typedef struct {
+    bool in_use;
+    bool requested;
+    uint8_t retries; // 已经过的 cdex_nego_retry 次数
+    uint16_t descriptor_id;
+    uint8_t head;
+    uint8_t count;
+    uint16_t lens[CDEX_NEGO_QUEUE_DEPTH];
+    uint64_t sources[CDEX_NEGO_QUEUE_DEPTH];
+    uint8_t frames[CDEX_NEGO_QUEUE_DEPTH][CDEX_NEGO_MAX_FRAME_LEN];
+} cdex_nego_pending_t;
+
+/**
+ * @brief 接收端描述符协商引擎，所有存储均在结构体内，不使用堆内存
+ */
+typedef struct {
+    cdex_nego_transport_t transport;
+    cdex_nego_deliver_fn deliver;
+    void* deliver_ctx;
+    uint32_t dropped; // 因队列已满或没有空闲队列而丢弃的帧数
+    uint32_t oversized; // 超过 CDEX_NEGO_MAX_FRAME_LEN 无法暂存而丢弃的帧数
+    uint32_t rejected; // 描述符注册后仍无法解析而丢弃的暂存帧数
+    uint32_t expired; // 超过重试上限或被取消而丢弃的暂存帧数
+    uint8_t max_retries; // 初始化为 CDEX_NEGO_MAX_RETRIES，可在初始化后修改
+    cdex_nego_pending_t pending[CDEX_NEGO_MAX_PENDING_IDS];
+} cdex_negotiator_t;
+
+/**
+ * @brief 初始化协商引擎
+ * @param nego 指向协商引擎
+ * @param transport 传输层，用于向发送方请求描述符
+ * @param deliver 解析成功后的数据包交付回调
+ * @param deliver_ctx 交付回调的上下文
+ */
+void cdex_nego_init(cdex_negotiator_t* nego, const cdex_nego_transport_t* transport,
+                    cdex_nego_deliver_fn deliver, void* deliver_ctx);
+
+/**
+ * @brief 提交一个接收到的 CDEX 帧
+ *
+ * 描述符已知时直接解析并交付；描述符未知时将帧暂存到该ID的队列中，
+ * 并且每个ID只发出一次描述符请求。
+ * @return CDEX_SUCCESS 已交付；CDEX_PENDING_DESCRIPTOR 已暂存等待描述符；
+ *         CDEX_ERROR_QUEUE_FULL 队列已满，帧被丢弃；其它为 cdex_parse 的错误码
+ */
+cdex_status_t cdex_nego_submit(cdex_negotiator_t* nego, const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief 同 cdex_nego_submit，并为暂存的帧记录来源标识，供 cdex_nego_drain_raw 使用
+ * @param source 调用者定义的来源标识，例如来源地址和端口
+ */
+cdex_status_t cdex_nego_submit_from(cdex_negotiator_t* nego, const uint8_t* buffer, size_t buffer_len,
+                                    uint64_t source);
+
+/**
+ * @brief 注册发送方返回的描述符，并批量交付该ID下暂存的所有帧
+ * @param nego 指向协商引擎
+ * @param id 描述符ID
+ * @param descriptor_string 描述符字符串
+ * @return cdex_descriptor_register 的状态码，CDEX_ERROR_ID_EXISTS 时同样会交付暂存帧
+ */
+cdex_status_t cdex_nego_register(cdex_negotiator_t* nego, uint16_t id, const char* descriptor_string);
+
+/**
+ * @brief 描述符已通过其它途径注册时，批量交付该ID下暂存的帧
+ * @return 成功交付的帧数
+ */
+int cdex_nego_drain(cdex_negotiator_t* nego, uint16_t id);
+
+/**
+ * @brief 按到达顺序把该ID下暂存的帧原样交给回调，不解析，并释放该ID的队列
+ * @return 交付的帧数
+ */
+int cdex_nego_drain_raw(cdex_negotiator_t* nego, uint16_t id, cdex_nego_raw_fn fn, void* ctx);
+
+/**
+ * @brief 为所有仍未完成的ID重新发送描述符请求 (用于请求丢失后的定时重试)
+ *
+ * 每次调用为每个ID计一次重试，超过 max_retries 的ID视为发送方不会应答，
+ * 丢弃其暂存帧 (计入 expired) 并释放队列。调用间隔即暂存帧的老化粒度。
+ * @return 发出的请求数
+ */
+int cdex_nego_retry(cdex_negotiator_t* nego);
+
+/**
+ * @brief 放弃某个ID的协商，丢弃其暂存帧 (计入 expired) 并释放队列
+ * @return 丢弃的帧数
+ */
+int cdex_nego_cancel(cdex_negotiator_t* nego, uint16_t id);
+
+/**
+ * @brief 查询某个ID下暂存的帧数
+ */
+int cdex_nego_pending_count(const cdex_negotiator_t* nego, uint16_t id);
+
+// --- 控制消息 ---
+//
+// 控制消息与数据帧共用链路，以保留的描述符ID 0xFFFF 开头：
+// | 0xFFFF (2) | op (1) | 描述符ID (2) | 描述符字符串，以 '\0' 结尾 (仅 CDEX_NEGO_OP_DESCRIPTOR) |
+
+#define CDEX_NEGO_CONTROL_ID CDEX_RESERVED_ID
+
+typedef enum {
+    CDEX_NEGO_OP_REQUEST = 1,    // 接收方 -> 发送方：未知描述符ID
+    CDEX_NEGO_OP_DESCRIPTOR = 2, // 发送方 -> 接收方：新描述符
+    CDEX_NEGO_OP_ACK = 3         // 接收方 -> 发送方：描述符已注册
+} cdex_nego_op_t;
+
+/**
+ * @brief 判断一个数据报是否为控制消息
+ */
+bool cdex_nego_is_control(const uint8_t* buffer, size_t buffer_len);
+
+/**
+ * @brief 编码控制消息
+ * @param descriptor_string 描述符字符串，仅 CDEX_NEGO_OP_DESCRIPTOR 需要，其它可为NULL
+ * @return 成功则返回编码后的字节数，失败返回-1
+ */
+int cdex_nego_encode_control(cdex_nego_op_t op, uint16_t id, const char* descriptor_string,
+                             uint8_t* buffer, size_t buffer_size);
+
+/**
+ * @brief 解码控制消息
+ * @param descriptor_string [out] 指向 buffer 内的描述符字符串，非 CDEX_NEGO_OP_DESCRIPTOR 时为NULL
+ * @return 状态码 (CDEX_SUCCESS 表示成功)
+ */
+cdex_status_t cdex_nego_decode_control(const uint8_t* buffer, size_t buffer_len, cdex_nego_op_t* op,
+                                       uint16_t* id, const char** descriptor_string);
+
+// --- 回环传输，模拟持有描述符的发送方，用于测试 ---
+
+#define CDEX_NEGO_LOOPBACK_MAX 16
+
+typedef struct {
+    int known_count;
+    uint16_t known_ids[CDEX_NEGO_LOOPBACK_MAX];
+    const char* known_strings[CDEX_NEGO_LOOPBACK_MAX];
+    int outbox_count;
+    uint16_t outbox[CDEX_NEGO_LOOPBACK_MAX];
+    uint32_t requests; // 累计收到的请求数
+} cdex_nego_loopback_t;
+
+/**
+ * @brief 初始化回环传输，并填充 transport 以便传给 cdex_nego_init
+ */
+void cdex_nego_loopback_init(cdex_nego_loopback_t* loopback, cdex_nego_transport_t* transport);
+
+/**
+ * @brief 为回环发送方添加一个已知描述符，字符串需在回环生命周期内有效
+ */
+cdex_status_t cdex_nego_loopback_add(cdex_nego_loopback_t* loopback, uint16_t id, const char* descriptor_string);
+
+/**
+ * @brief 应答所有积压的描述符请求，应答过程中新产生的请求留到下一次调用
+ * @return 应答的请求数
+ */
+int cdex_nego_loopback_pump(cdex_nego_loopback_t* loopback, cdex_negotiator_t* nego);
+
+#endif // CDEX_NEGOTIATE_H
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "cdex.h"
+#include "cdex_negotiate.h"
 
 void print_hex(const char* title, const uint8_t* data, int len) {
     printf("%s (%d bytes): ", title, len);
@@ -17,6 +18,12 @@ void print_packet_details(const cdex_packet_t* packet) {
     printf("  Data Count: %d\n", packet->data_count);
 }
 
+static void print_delivered(const cdex_packet_t* packet, void* ctx) {
+    (void)ctx;
+    printf("Delivered packet for descriptor %u, bitmap 0x%llx\n",
+           packet->descriptor_id, (unsigned long long)packet->bitmap);
+}
+
 int main() {
     printf("CDEX Protocol Dynamic Descriptor Demo\n======================================\n\n");
 
@@ -35,11 +42,11 @@ int main() {
 
     // 方法 B: 通过预定义结构体数组加载
     cdex_field_t power_fields[] = {
-        {"voltage", CDEX_TYPE_I16, 2},
-        {"current", CDEX_TYPE_I16, 2},
-        {"power", CDEX_TYPE_F32, 4},
-        {"error_code", CDEX_TYPE_U32, 4},
-        {"uptime", CDEX_TYPE_U64, 8}
+        {"voltage", CDEX_TYPE_I16, 2, 0},
+        {"current", CDEX_TYPE_I16, 2, 0},
+        {"power", CDEX_TYPE_F32, 4, 0},
+        {"error_code", CDEX_TYPE_U32, 4, 0},
+        {"uptime", CDEX_TYPE_U64, 8, 0}
     };
     int power_field_count = sizeof(power_fields) / sizeof(power_fields[0]);
     cdex_status_t load_status = cdex_descriptor_load(2005, power_fields, power_field_count);
@@ -93,8 +100,34 @@ int main() {
         printf("Parsing failed with code %d\n", parse_status);
     }
 
-    // --- 4. 清理 ---
-    printf("\n--- 4. Cleaning Up ---\n");
+    // --- 4. 描述符协商 ---
+    printf("\n--- 4. Descriptor Negotiation ---\n");
+    static cdex_negotiator_t nego;
+    cdex_nego_loopback_t loopback;
+    cdex_nego_transport_t transport;
+    cdex_nego_loopback_init(&loopback, &transport);
+    cdex_nego_loopback_add(&loopback, 3001, "rssi:i8,snr:i8");
+    cdex_nego_init(&nego, &transport, print_delivered, NULL);
+
+    // 先用描述符 3001 构造发送方的字节流，再清空注册表模拟接收端尚未持有该描述符
+    cdex_descriptor_register(3001, "rssi:i8,snr:i8");
+    cdex_packet_init(&packet_to_pack, 3001);
+    val.i8 = -87;
+    cdex_packet_push(&packet_to_pack, 0, val);
+    uint8_t unknown_frame[16];
+    int unknown_len = cdex_pack(&packet_to_pack, unknown_frame, sizeof(unknown_frame));
+    cdex_manager_cleanup();
+
+    for (int i = 0; i < 3; ++i) {
+        cdex_status_t submit_status = cdex_nego_submit(&nego, unknown_frame, unknown_len);
+        printf("Submit #%d: status %d, pending %d\n", i, submit_status, cdex_nego_pending_count(&nego, 3001));
+    }
+    printf("Descriptor requests sent: %u\n", loopback.requests);
+    cdex_nego_loopback_pump(&loopback, &nego);
+    printf("Pending after negotiation: %d\n", cdex_nego_pending_count(&nego, 3001));
+
+    // --- 5. 清理 ---
+    printf("\n--- 5. Cleaning Up ---\n");
     cdex_manager_cleanup();
     printf("Descriptor manager cleaned up.\n");
     
@@ -0,0 +1,753 @@
+/**
+ * @file cdex_ingestd.c
+ * @brief CDEX UDP 接收服务参考实现
+ *
+ * 接收线程使用 recvmmsg 批量收包，按 (来源地址, 描述符ID) 哈希分发到绑核的工作线程，
+ * 工作线程解析后以 NDJSON (每行一个 JSON 对象) 写入标准输出或文件。
+ * 未知描述符ID按 README 中的动态获取流程处理：帧暂存在协商引擎中，向发送方请求描述符，
+ * 注册成功后交付暂存帧并回复确认。
+ *
+ * 描述符注册只发生在接收线程，工作线程只读注册表，两者之间用读写锁隔离。
+ * 指定 -c 时接收线程同时把原始帧写入抓包文件，供 cdex_replay 回放。
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "cdex.h"
+#include "cdex_capture.h"
+#include "cdex_negotiate.h"
+#include "cjson/cJSON.h"
+
+#define INGEST_BATCH 64            // 每次 recvmmsg 最多接收的数据报数
+#define INGEST_MAX_FRAME 512       // 单个数据报的最大长度
+#define INGEST_RING_SIZE 4096      // 每个工作线程的队列槽数，必须是2的幂
+#define INGEST_MAX_WORKERS 64
+#define INGEST_OUT_BUF (64 * 1024) // 每个线程的输出缓冲
+#define INGEST_IDLE_SPINS 1024     // 空转多少次后让出CPU
+#define LATENCY_BUCKETS 256
+#define INGEST_MAX_DICTS (1 << 16) // 每个工作线程最多维护的 (来源, 描述符ID) 字典数
+#define INGEST_MAX_PEERS (CDEX_NEGO_MAX_PENDING_IDS * 2) // 记录发送方的待协商ID数
+
+// 已知描述符都按 (来源, 描述符ID) 哈希分发，同一来源的帧保持顺序
+enum {
+    ROUTE_UNKNOWN = 0,
+    ROUTE_SPREAD,
+    ROUTE_DICT     // 含 dstr 字段，每个 (来源, 描述符ID) 使用独立的接收字典
+};
+
+typedef struct {
+    uint64_t recv_ns;
+    uint64_t source;   // 来源地址和端口，见 source_key
+    bool dict;
+    uint16_t len;
+    uint8_t data[INGEST_MAX_FRAME];
+} frame_slot_t;
+
+typedef struct {
+    uint64_t key;      // 来源 << 16 | 描述符ID
+    cdex_dict_t* dict; // 为NULL表示空位
+} dict_entry_t;
+
+typedef struct {
+    FILE* file;
+    pthread_mutex_t lock;
+    bool json;
+} output_t;
+
+typedef struct {
+    char buf[INGEST_OUT_BUF];
+    size_t len;
+} line_buffer_t;
+
+typedef struct {
+    pthread_t thread;
+    int cpu; // -1 表示不绑核
+    _Atomic uint32_t head; // 仅接收线程写
+    _Atomic uint32_t tail; // 仅工作线程写
+    _Atomic uint64_t decoded;
+    _Atomic uint64_t errors;
+    uint64_t latency[LATENCY_BUCKETS];
+    dict_entry_t* dicts;   // 开放寻址哈希表，仅本工作线程访问
+    uint32_t dict_mask;
+    uint32_t dict_count;
+    line_buffer_t out;
+    frame_slot_t slots[INGEST_RING_SIZE];
+} worker_t;
+
+typedef struct {
+    uint16_t id;
+    socklen_t len; // 0 表示空闲
+    struct sockaddr_storage addr;
+} peer_entry_t;
+
+typedef struct {
+    int fd;
+    peer_entry_t peers[INGEST_MAX_PEERS]; // 每个待协商ID最近一次的发送方，描述符请求发往该地址
+} link_t;
+
+static volatile sig_atomic_t g_stop = 0;
+static pthread_rwlock_t g_registry_lock;
+static uint8_t g_route[65536]; // 仅接收线程读写
+static output_t g_output;
+static worker_t* g_workers;
+static int g_worker_count;
+
+// 协商引擎与交付缓冲只在接收线程使用
+static cdex_negotiator_t g_nego;
+static line_buffer_t g_nego_out;
+static uint64_t g_negotiated;
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+// --- 延迟直方图：每个2的幂区间再细分4档 ---
+
+static int latency_bucket(uint64_t ns) {
+    if (ns < 4) return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    return msb * 4 + (int)((ns >> (msb - 2)) & 3);
+}
+
+static uint64_t bucket_upper(int bucket) {
+    if (bucket < 8) return (uint64_t)bucket;
+    int msb = bucket / 4;
+    uint64_t lower = (uint64_t)(4 + bucket % 4) << (msb - 2);
+    return lower + (1ULL << (msb - 2)) - 1;
+}
+
+static uint64_t latency_percentile(const uint64_t* hist, uint64_t total, double p) {
+    if (total == 0) return 0;
+    uint64_t target = (uint64_t)(total * p);
+    if (target >= total) target = total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += hist[i];
+        if (seen > target) return bucket_upper(i);
+    }
+    return bucket_upper(LATENCY_BUCKETS - 1);
+}
+
+// --- 输出 ---
+
+static void output_flush(line_buffer_t* out) {
+    if (out->len == 0) return;
+    pthread_mutex_lock(&g_output.lock);
+    fwrite(out->buf, 1, out->len, g_output.file);
+    pthread_mutex_unlock(&g_output.lock);
+    out->len = 0;
+}
+
+static void output_packet(line_buffer_t* out, const cdex_packet_t* packet) {
+    if (!g_output.json) return;
+    cJSON* json = cdex_packet_to_json(packet);
+    if (!json) return;
+    char* line = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (!line) return;
+    size_t len = strlen(line);
+    if (out->len + len + 1 > sizeof(out->buf)) {
+        output_flush(out);
+    }
+    if (len + 1 > sizeof(out->buf)) {
+        // 超长的行直接写出，保证行不被拆开
+        pthread_mutex_lock(&g_output.lock);
+        fwrite(line, 1, len, g_output.file);
+        fputc('\n', g_output.file);
+        pthread_mutex_unlock(&g_output.lock);
+    } else {
+        memcpy(out->buf + out->len, line, len);
+        out->len += len;
+        out->buf[out->len++] = '\n';
+    }
+    free(line);
+}
+
+// --- 工作线程 ---
+
+static uint32_t dict_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static bool worker_grow_dicts(worker_t* worker) {
+    uint32_t size = worker->dicts ? (worker->dict_mask + 1) * 2 : 64;
+    dict_entry_t* grown = (dict_entry_t*)calloc(size, sizeof(dict_entry_t));
+    if (!grown) return false;
+    for (uint32_t i = 0; worker->dicts && i <= worker->dict_mask; ++i) {
+        if (!worker->dicts[i].dict) continue;
+        uint32_t pos = dict_hash(worker->dicts[i].key) & (size - 1);
+        while (grown[pos].dict) pos = (pos + 1) & (size - 1);
+        grown[pos] = worker->dicts[i];
+    }
+    free(worker->dicts);
+    worker->dicts = grown;
+    worker->dict_mask = size - 1;
+    return true;
+}
+
+/**
+ * @brief 查找 (来源, 描述符ID) 的接收字典，不存在时创建
+ * @return 字典，内存不足或数量超过 INGEST_MAX_DICTS 时返回NULL
+ */
+static cdex_dict_t* worker_dict(worker_t* worker, uint64_t key) {
+    if (worker->dicts) {
+        uint32_t pos = dict_hash(key) & worker->dict_mask;
+        while (worker->dicts[pos].dict) {
+            if (worker->dicts[pos].key == key) return worker->dicts[pos].dict;
+            pos = (pos + 1) & worker->dict_mask;
+        }
+    }
+    if (worker->dict_count >= INGEST_MAX_DICTS) return NULL;
+    if ((!worker->dicts || (worker->dict_count + 1) * 2 > worker->dict_mask + 1) && !worker_grow_dicts(worker)) {
+        return NULL;
+    }
+    cdex_dict_t* dict = (cdex_dict_t*)malloc(sizeof(cdex_dict_t));
+    if (!dict) return NULL;
+    cdex_dict_init(dict, false);
+    uint32_t pos = dict_hash(key) & worker->dict_mask;
+    while (worker->dicts[pos].dict) pos = (pos + 1) & worker->dict_mask;
+    worker->dicts[pos].key = key;
+    worker->dicts[pos].dict = dict;
+    worker->dict_count++;
+    return dict;
+}
+
+static void worker_free_dicts(worker_t* worker) {
+    for (uint32_t i = 0; worker->dicts && i <= worker->dict_mask; ++i) {
+        free(worker->dicts[i].dict);
+    }
+    free(worker->dicts);
+    worker->dicts = NULL;
+}
+
+static void* worker_main(void* arg) {
+    worker_t* worker = (worker_t*)arg;
+    if (worker->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    int idle = 0;
+    for (;;) {
+        uint32_t tail = atomic_load_explicit(&worker->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&worker->head, memory_order_acquire);
+        if (tail == head) {
+            if (g_stop) break;
+            if (++idle >= INGEST_IDLE_SPINS) {
+                output_flush(&worker->out);
+                struct timespec nap = {0, 50000};
+                nanosleep(&nap, NULL);
+                idle = 0;
+            }
+            continue;
+        }
+        idle = 0;
+
+        frame_slot_t* slot = &worker->slots[tail & (INGEST_RING_SIZE - 1)];
+        cdex_packet_t packet;
+        memset(&packet, 0, sizeof(packet)); // 解析失败后仍会统一释放
+        cdex_status_t status = CDEX_ERROR_MEMORY_ALLOCATION;
+        cdex_dict_t* dict = NULL;
+        if (slot->dict) {
+            uint16_t id = (uint16_t)(slot->data[0] | (slot->data[1] << 8));
+            dict = worker_dict(worker, slot->source << 16 | id);
+        }
+        pthread_rwlock_rdlock(&g_registry_lock);
+        if (!slot->dict) {
+            status = cdex_parse(slot->data, slot->len, &packet);
+        } else if (dict) {
+            status = cdex_parse_with_dict(slot->data, slot->len, dict, &packet);
+        }
+        if (status == CDEX_SUCCESS) {
+            output_packet(&worker->out, &packet);
+        }
+        pthread_rwlock_unlock(&g_registry_lock);
+        cdex_free_packet_memory(&packet);
+
+        if (status == CDEX_SUCCESS) {
+            worker->latency[latency_bucket(now_ns() - slot->recv_ns)]++;
+            atomic_fetch_add_explicit(&worker->decoded, 1, memory_order_relaxed);
+        } else {
+            atomic_fetch_add_explicit(&worker->errors, 1, memory_order_relaxed);
+        }
+        atomic_store_explicit(&worker->tail, tail + 1, memory_order_release);
+    }
+    output_flush(&worker->out);
+    worker_free_dicts(worker);
+    return NULL;
+}
+
+static bool worker_push(worker_t* worker, const uint8_t* data, size_t len, uint64_t recv_ns,
+                        uint64_t source, bool dict) {
+    uint32_t head = atomic_load_explicit(&worker->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&worker->tail, memory_order_acquire);
+    if (head - tail >= INGEST_RING_SIZE) return false;
+    frame_slot_t* slot = &worker->slots[head & (INGEST_RING_SIZE - 1)];
+    memcpy(slot->data, data, len);
+    slot->len = (uint16_t)len;
+    slot->recv_ns = recv_ns;
+    slot->source = source;
+    slot->dict = dict;
+    atomic_store_explicit(&worker->head, head + 1, memory_order_release);
+    return true;
+}
+
+// --- 描述符注册与协商 ---
+
+/**
+ * @brief 记录未知ID的发送方，表项满时复用已不在协商中的ID
+ */
+static void link_set_peer(link_t* link, uint16_t id, const struct sockaddr_storage* src, socklen_t src_len) {
+    peer_entry_t* entry = NULL;
+    for (int i = 0; i < INGEST_MAX_PEERS; ++i) {
+        peer_entry_t* candidate = &link->peers[i];
+        if (candidate->len && candidate->id == id) {
+            entry = candidate;
+            break;
+        }
+        if (!entry && (candidate->len == 0 || cdex_nego_pending_count(&g_nego, candidate->id) == 0)) {
+            entry = candidate;
+        }
+    }
+    // 待协商的ID不超过 CDEX_NEGO_MAX_PENDING_IDS，总能找到表项
+    if (!entry) return;
+    entry->id = id;
+    memcpy(&entry->addr, src, src_len);
+    entry->len = src_len;
+}
+
+static cdex_status_t send_descriptor_request(uint16_t descriptor_id, void* ctx) {
+    link_t* link = (link_t*)ctx;
+    const peer_entry_t* peer = NULL;
+    for (int i = 0; i < INGEST_MAX_PEERS && !peer; ++i) {
+        if (link->peers[i].len && link->peers[i].id == descriptor_id) peer = &link->peers[i];
+    }
+    uint8_t msg[8];
+    int len = cdex_nego_encode_control(CDEX_NEGO_OP_REQUEST, descriptor_id, NULL, msg, sizeof(msg));
+    if (len < 0 || !peer) return CDEX_ERROR_INVALID_DATA;
+    if (sendto(link->fd, msg, (size_t)len, 0, (const struct sockaddr*)&peer->addr, peer->len) != len) {
+        return CDEX_ERROR_INVALID_DATA;
+    }
+    return CDEX_SUCCESS;
+}
+
+static void deliver_negotiated(const cdex_packet_t* packet, void* ctx) {
+    (void)ctx;
+    output_packet(&g_nego_out, packet);
+    g_negotiated++;
+}
+
+/**
+ * @brief 为新注册的描述符决定分发方式
+ *
+ * 每个发送方各自维护 dstr 字典，带内新增的索引只对该发送方有效，
+ * 因此含 dstr 字段的描述符由工作线程按 (来源, 描述符ID) 使用独立的字典解析。
+ */
+static void route_descriptor(uint16_t id) {
+    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(id);
+    if (!desc) return;
+    g_route[id] = ROUTE_SPREAD;
+    for (int i = 0; i < desc->field_count; ++i) {
+        if (desc->fields[i].type == CDEX_TYPE_DSTR) {
+            g_route[id] = ROUTE_DICT;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief IPv4 来源的地址和端口，低 48 位有效
+ */
+static uint64_t source_key(const struct sockaddr_storage* src) {
+    const struct sockaddr_in* in = (const struct sockaddr_in*)src;
+    return (uint64_t)ntohl(in->sin_addr.s_addr) << 16 | ntohs(in->sin_port);
+}
+
+static worker_t* source_worker(uint64_t source, uint16_t id) {
+    return &g_workers[dict_hash(source << 16 | id) % (uint32_t)g_worker_count];
+}
+
+/**
+ * @brief 暂存帧交给工作线程，与后续帧一样按来源使用字典解析
+ */
+static uint64_t g_drain_ring_full; // 交付暂存帧时队列已满的帧数
+
+static void forward_pending(const uint8_t* frame, size_t len, uint64_t source, void* ctx) {
+    (void)ctx;
+    uint16_t id = (uint16_t)(frame[0] | (frame[1] << 8));
+    if (!worker_push(source_worker(source, id), frame, len, now_ns(), source, true)) {
+        g_drain_ring_full++;
+    }
+}
+
+static cdex_status_t register_descriptor(uint16_t id, const char* descriptor_string) {
+    pthread_rwlock_wrlock(&g_registry_lock);
+    cdex_status_t status = cdex_descriptor_register(id, descriptor_string);
+    if (status == CDEX_SUCCESS) {
+        route_descriptor(id);
+    }
+    pthread_rwlock_unlock(&g_registry_lock);
+    if (status == CDEX_SUCCESS || status == CDEX_ERROR_ID_EXISTS) {
+        // 注册表此后只会被本线程修改，交付暂存帧时不需要持锁
+        if (g_route[id] == ROUTE_DICT) {
+            cdex_nego_drain_raw(&g_nego, id, forward_pending, NULL);
+        } else {
+            cdex_nego_drain(&g_nego, id);
+            output_flush(&g_nego_out);
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief 加载描述符文件，每行为 "<ID> <描述符字符串>"，'#' 开头为注释
+ */
+static int load_descriptor_file(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+    char line[1024];
+    int loaded = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* end;
+        unsigned long id = strtoul(line, &end, 0);
+        if (end == line || line[0] == '#') continue;
+        while (*end == ' ' || *end == '\t') end++;
+        if (id > 0xFFFF || *end == '\0' || register_descriptor((uint16_t)id, end) != CDEX_SUCCESS) {
+            fprintf(stderr, "skip invalid descriptor line: %s\n", line);
+            continue;
+        }
+        loaded++;
+    }
+    fclose(file);
+    return loaded;
+}
+
+// --- 接收线程 ---
+
+typedef struct {
+    uint64_t received;
+    uint64_t ring_full;
+    uint64_t invalid;
+    uint64_t control;
+} recv_stats_t;
+
+static void handle_control(link_t* link, const uint8_t* data, size_t len,
+                           const struct sockaddr_storage* src, socklen_t src_len, recv_stats_t* stats) {
+    cdex_nego_op_t op;
+    uint16_t id;
+    const char* descriptor_string;
+    stats->control++;
+    if (cdex_nego_decode_control(data, len, &op, &id, &descriptor_string) != CDEX_SUCCESS) {
+        stats->invalid++;
+        return;
+    }
+    if (op != CDEX_NEGO_OP_DESCRIPTOR) return; // 接收端忽略请求与确认
+    cdex_status_t status = register_descriptor(id, descriptor_string);
+    if (status == CDEX_SUCCESS || status == CDEX_ERROR_ID_EXISTS) {
+        uint8_t ack[8];
+        int ack_len = cdex_nego_encode_control(CDEX_NEGO_OP_ACK, id, NULL, ack, sizeof(ack));
+        sendto(link->fd, ack, (size_t)ack_len, 0, (const struct sockaddr*)src, src_len);
+    } else {
+        stats->invalid++;
+    }
+}
+
+static void handle_frame(link_t* link, const uint8_t* data, size_t len, uint64_t recv_ns,
+                         const struct sockaddr_storage* src, socklen_t src_len, recv_stats_t* stats) {
+    if (len < 4 || len > INGEST_MAX_FRAME) {
+        stats->invalid++;
+        return;
+    }
+    if (cdex_nego_is_control(data, len)) {
+        handle_control(link, data, len, src, src_len, stats);
+        return;
+    }
+
+    uint16_t id = (uint16_t)(data[0] | (data[1] << 8));
+    uint64_t source = source_key(src);
+    switch (g_route[id]) {
+        case ROUTE_SPREAD:
+        case ROUTE_DICT:
+            break;
+        default:
+            link_set_peer(link, id, src, src_len);
+            switch (cdex_nego_submit_from(&g_nego, data, len, source)) {
+                case CDEX_SUCCESS:
+                case CDEX_PENDING_DESCRIPTOR:
+                case CDEX_ERROR_QUEUE_FULL: // 已计入 nego_dropped
+                    break;
+                default:
+                    stats->invalid++;
+                    break;
+            }
+            return;
+    }
+    if (!worker_push(source_worker(source, id), data, len, recv_ns, source, g_route[id] == ROUTE_DICT)) {
+        stats->ring_full++;
+    }
+}
+
+static void report(const recv_stats_t* stats, uint64_t elapsed_ns, bool final) {
+    uint64_t decoded = g_negotiated, errors = 0;
+    uint64_t hist[LATENCY_BUCKETS] = {0};
+    uint64_t measured = 0;
+    for (int w = 0; w < g_worker_count; ++w) {
+        decoded += atomic_load_explicit(&g_workers[w].decoded, memory_order_relaxed);
+        errors += atomic_load_explicit(&g_workers[w].errors, memory_order_relaxed);
+        if (final) {
+            for (int i = 0; i < LATENCY_BUCKETS; ++i) hist[i] += g_workers[w].latency[i];
+        }
+    }
+    double seconds = elapsed_ns / 1e9;
+    fprintf(stderr, "received=%llu decoded=%llu (%.0f pkt/s) errors=%llu ring_full=%llu invalid=%llu "
+            "control=%llu nego_dropped=%u nego_oversized=%u nego_rejected=%u nego_expired=%u\n",
+            (unsigned long long)stats->received, (unsigned long long)decoded,
+            seconds > 0 ? decoded / seconds : 0.0, (unsigned long long)errors,
+            (unsigned long long)(stats->ring_full + g_drain_ring_full), (unsigned long long)stats->invalid,
+            (unsigned long long)stats->control, g_nego.dropped, g_nego.oversized,
+            g_nego.rejected, g_nego.expired);
+    if (!final) return;
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) measured += hist[i];
+    int max_bucket = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+        if (hist[i]) max_bucket = i;
+    }
+    fprintf(stderr, "latency (recv -> decoded, ns): p50<=%llu p99<=%llu p99.9<=%llu max<=%llu\n",
+            (unsigned long long)latency_percentile(hist, measured, 0.50),
+            (unsigned long long)latency_percentile(hist, measured, 0.99),
+            (unsigned long long)latency_percentile(hist, measured, 0.999),
+            (unsigned long long)(measured ? bucket_upper(max_bucket) : 0));
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -p <port>     UDP port (default 9000)\n"
+            "  -b <addr>     bind address (default 0.0.0.0)\n"
+            "  -w <n>        worker threads (default: online CPUs - 1)\n"
+            "  -o <file>     NDJSON output file (default stdout)\n"
+            "  -d <file>     preload descriptors, one \"<id> <descriptor>\" per line\n"
+            "  -s <sec>      print stats to stderr every <sec> seconds (default 0, off)\n"
+            "  -q            decode only, no NDJSON output\n"
+            "  -n            do not pin the receiver and worker threads to CPUs\n"
+            "  -c <file>     record raw frames to a capture file\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    int port = 9000;
+    const char* bind_addr = "0.0.0.0";
+    const char* out_path = NULL;
+    const char* desc_path = NULL;
+    const char* capture_path = NULL;
+    int stats_interval = 0;
+    bool pin = true;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    g_worker_count = cpus > 1 ? (int)cpus - 1 : 1;
+    g_output.json = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:b:w:o:d:s:c:qnh")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'b': bind_addr = optarg; break;
+            case 'w': g_worker_count = atoi(optarg); break;
+            case 'o': out_path = optarg; break;
+            case 'd': desc_path = optarg; break;
+            case 's': stats_interval = atoi(optarg); break;
+            case 'q': g_output.json = false; break;
+            case 'n': pin = false; break;
+            case 'c': capture_path = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (g_worker_count < 1 || g_worker_count > INGEST_MAX_WORKERS) {
+        fprintf(stderr, "worker count must be 1..%d\n", INGEST_MAX_WORKERS);
+        return 1;
+    }
+
+    g_output.file = out_path ? fopen(out_path, "w") : stdout;
+    if (!g_output.file) {
+        perror(out_path);
+        return 1;
+    }
+    pthread_mutex_init(&g_output.lock, NULL);
+
+    link_t link;
+    memset(&link, 0, sizeof(link));
+    link.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (link.fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    int rcvbuf = 8 * 1024 * 1024;
+    setsockopt(link.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct timeval timeout = {0, 100000}; // 定期醒来检查退出标志和重试请求
+    setsockopt(link.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, bind_addr, &addr.sin_addr) != 1 ||
+        bind(link.fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    // 工作线程持续持有读锁，写者优先才能保证注册不会被饿死
+    pthread_rwlockattr_t lock_attr;
+    pthread_rwlockattr_init(&lock_attr);
+    pthread_rwlockattr_setkind_np(&lock_attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&g_registry_lock, &lock_attr);
+    pthread_rwlockattr_destroy(&lock_attr);
+
+    cdex_manager_init();
+    cdex_nego_transport_t transport = { send_descriptor_request, &link };
+    cdex_nego_init(&g_nego, &transport, deliver_negotiated, NULL);
+    if (desc_path && load_descriptor_file(desc_path) < 0) {
+        return 1;
+    }
+
+    cdex_capture_writer_t capture;
+    if (capture_path && cdex_capture_open(&capture, capture_path) != CDEX_SUCCESS) {
+        perror(capture_path);
+        return 1;
+    }
+    bool capturing = capture_path != NULL;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    g_workers = (worker_t*)calloc((size_t)g_worker_count, sizeof(worker_t));
+    if (!g_workers) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    // 接收线程绑定 CPU 0，工作线程轮流绑定其余核心；只有一个核心时不绑核
+    pin = pin && cpus > 1;
+    for (int w = 0; w < g_worker_count; ++w) {
+        g_workers[w].cpu = pin ? (int)(1 + w % (cpus - 1)) : -1;
+        int err = pthread_create(&g_workers[w].thread, NULL, worker_main, &g_workers[w]);
+        if (err != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(err));
+            g_stop = 1;
+            for (int started = 0; started < w; ++started) {
+                pthread_join(g_workers[started].thread, NULL);
+            }
+            return 1;
+        }
+    }
+    if (pin) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(0, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    fprintf(stderr, "cdex_ingestd listening on %s:%d with %d workers\n", bind_addr, port, g_worker_count);
+
+    static uint8_t buffers[INGEST_BATCH][INGEST_MAX_FRAME + 1];
+    static struct sockaddr_storage sources[INGEST_BATCH];
+    struct mmsghdr msgs[INGEST_BATCH];
+    struct iovec iovs[INGEST_BATCH];
+    recv_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    uint64_t start = 0, last_tick = now_ns(), last_report = last_tick;
+    while (!g_stop) {
+        for (int i = 0; i < INGEST_BATCH; ++i) {
+            iovs[i].iov_base = buffers[i];
+            iovs[i].iov_len = sizeof(buffers[i]);
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &sources[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+        }
+        int n = recvmmsg(link.fd, msgs, INGEST_BATCH, MSG_WAITFORONE, NULL);
+        uint64_t now = now_ns();
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            perror("recvmmsg");
+            break;
+        }
+        if (n > 0 && start == 0) start = now;
+        uint64_t capture_ts = capturing && n > 0 ? wall_ns() : 0;
+        for (int i = 0; i < n; ++i) {
+            stats.received++;
+            if (capturing && msgs[i].msg_len >= 4 && msgs[i].msg_len <= INGEST_MAX_FRAME &&
+                !cdex_nego_is_control(buffers[i], msgs[i].msg_len)) {
+                cdex_status_t capture_status = cdex_capture_append(&capture, capture_ts, buffers[i], msgs[i].msg_len);
+                if (capture_status != CDEX_SUCCESS) {
+                    // 磁盘写满等错误不影响接收，停止抓包，已写出的块在退出时照常建立索引
+                    fprintf(stderr, "capture append failed (status %d), capture stopped: %s\n", capture_status,
+                            capture_path);
+                    capturing = false;
+                }
+            }
+            handle_frame(&link, buffers[i], msgs[i].msg_len, now,
+                         &sources[i], msgs[i].msg_hdr.msg_namelen, &stats);
+        }
+        output_flush(&g_nego_out);
+
+        if (now - last_tick >= 1000000000ULL) {
+            cdex_nego_retry(&g_nego); // 请求或应答丢失时重发
+            last_tick = now;
+        }
+        if (stats_interval > 0 && start && now - last_report >= (uint64_t)stats_interval * 1000000000ULL) {
+            report(&stats, now - start, false);
+            last_report = now;
+        }
+    }
+
+    uint64_t end = now_ns();
+    for (int w = 0; w < g_worker_count; ++w) {
+        pthread_join(g_workers[w].thread, NULL);
+    }
+    report(&stats, start ? end - start : 0, true);
+    if (capture_path && cdex_capture_close(&capture) != CDEX_SUCCESS) {
+        fprintf(stderr, "failed to write capture index: %s\n", capture_path);
+    }
+
+    fflush(g_output.file);
+    if (g_output.file != stdout) fclose(g_output.file);
+    close(link.fd);
+    free(g_workers);
+    cdex_manager_cleanup();
+    return 0;
+}
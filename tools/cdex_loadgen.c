@@ -0,0 +1,331 @@
+/**
+ * @file cdex_loadgen.c
+ * @brief cdex_ingestd 的负载生成器
+ *
+ * 预先打包一组随机取值的 CDEX 帧，通过多个 UDP 套接字 (模拟多个设备) 用 sendmmsg 循环重放，
+ * 可以限定速率。生成器同时扮演 README 动态获取流程中的发送方，应答接收端的描述符请求。
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "cdex.h"
+#include "cdex_negotiate.h"
+
+#define LOADGEN_BATCH 64
+#define LOADGEN_MAX_FRAME 512
+#define LOADGEN_MAX_SOCKETS 256
+#define LOADGEN_MAX_DESCRIPTORS 64
+
+typedef struct {
+    uint16_t id;
+    char* descriptor_string;
+    bool acked;
+} loadgen_descriptor_t;
+
+static loadgen_descriptor_t g_descs[LOADGEN_MAX_DESCRIPTORS];
+static int g_desc_count;
+
+static const char* g_default_descriptors[] = {
+    "temperature:s16:0.01,humidity:u8,voltage:f16,counter:u32,online:b1,mode:u3,site:dstr",
+    "rssi:i8,snr:i8,lat:d64,lon:d64,name:str,payload:bin",
+};
+
+static const char* g_sites[] = { "north", "south", "east", "west" };
+static uint8_t g_blob[] = { 4, 0xde, 0xad, 0xbe, 0xef }; // 首字节为长度
+
+static uint64_t g_rng = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int add_descriptor(uint16_t id, const char* descriptor_string) {
+    if (g_desc_count >= LOADGEN_MAX_DESCRIPTORS) return -1;
+    if (cdex_descriptor_register(id, descriptor_string) != CDEX_SUCCESS) return -1;
+    g_descs[g_desc_count].id = id;
+    g_descs[g_desc_count].descriptor_string = strdup(descriptor_string);
+    g_descs[g_desc_count].acked = false;
+    g_desc_count++;
+    return 0;
+}
+
+/**
+ * @brief 加载描述符文件，格式与 cdex_ingestd -d 相同
+ */
+static int load_descriptor_file(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* end;
+        unsigned long id = strtoul(line, &end, 0);
+        if (end == line || line[0] == '#') continue;
+        while (*end == ' ' || *end == '\t') end++;
+        if (id > 0xFFFF || *end == '\0' || add_descriptor((uint16_t)id, end) < 0) {
+            fprintf(stderr, "skip invalid descriptor line: %s\n", line);
+        }
+    }
+    fclose(file);
+    return g_desc_count;
+}
+
+static void random_value(const cdex_field_t* field, cdex_value_t* value) {
+    uint64_t r = next_random();
+    memset(value, 0, sizeof(cdex_value_t));
+    switch (field->type) {
+        case CDEX_TYPE_U8: value->u8 = (uint8_t)r; break;
+        case CDEX_TYPE_I8: value->i8 = (int8_t)r; break;
+        case CDEX_TYPE_U16: value->u16 = (uint16_t)r; break;
+        case CDEX_TYPE_I16: value->i16 = (int16_t)r; break;
+        case CDEX_TYPE_U32: value->u32 = (uint32_t)r; break;
+        case CDEX_TYPE_I32: value->i32 = (int32_t)r; break;
+        case CDEX_TYPE_U64: value->u64 = r; break;
+        case CDEX_TYPE_I64: value->i64 = (int64_t)r; break;
+        case CDEX_TYPE_NUM: value->i64 = (int64_t)(r % 20001) - 10000; break;
+        case CDEX_TYPE_F32: value->f32 = (float)(r % 100000) / 100.0f; break;
+        case CDEX_TYPE_D64: value->d64 = (double)(r % 100000000) / 1e6; break;
+        case CDEX_TYPE_BIN: value->bin = g_blob; break;
+        case CDEX_TYPE_STR:
+        case CDEX_TYPE_DSTR: value->str = (char*)g_sites[r % 4]; break;
+        case CDEX_TYPE_U1: case CDEX_TYPE_U2: case CDEX_TYPE_U3: case CDEX_TYPE_U4:
+        case CDEX_TYPE_U5: case CDEX_TYPE_U6: case CDEX_TYPE_U7:
+            value->u8 = (uint8_t)(r & ((1u << (field->type - CDEX_TYPE_U1 + 1)) - 1));
+            break;
+        case CDEX_TYPE_B1: value->u8 = (uint8_t)(r & 1); break;
+        case CDEX_TYPE_F16: value->f32 = (float)(r % 2000) / 10.0f - 100.0f; break;
+        case CDEX_TYPE_S8: value->d64 = (double)(int8_t)r * field->scale; break;
+        case CDEX_TYPE_S16: value->d64 = (double)(int16_t)r * field->scale; break;
+        case CDEX_TYPE_S32: value->d64 = (double)(int32_t)r * field->scale; break;
+        default: break;
+    }
+}
+
+/**
+ * @brief 打包一个随机帧，每个字段以 7/8 的概率出现
+ */
+static int make_frame(uint16_t id, uint8_t* buffer, size_t buffer_size) {
+    const cdex_descriptor_t* desc = cdex_get_descriptor_by_id(id);
+    if (!desc) return -1;
+    cdex_packet_t packet;
+    cdex_packet_init(&packet, id);
+    for (int i = 0; i < desc->field_count; ++i) {
+        if ((next_random() & 7) == 0) continue;
+        cdex_value_t value;
+        random_value(&desc->fields[i], &value);
+        cdex_packet_push(&packet, i, value);
+    }
+    return cdex_pack(&packet, buffer, buffer_size);
+}
+
+/**
+ * @brief 应答接收端的控制消息，返回处理的消息数
+ */
+static int serve_control(int fd) {
+    uint8_t msg[LOADGEN_MAX_FRAME];
+    int handled = 0;
+    for (;;) {
+        ssize_t len = recv(fd, msg, sizeof(msg), MSG_DONTWAIT);
+        if (len <= 0) break;
+        cdex_nego_op_t op;
+        uint16_t id;
+        if (cdex_nego_decode_control(msg, (size_t)len, &op, &id, NULL) != CDEX_SUCCESS) continue;
+        handled++;
+        for (int i = 0; i < g_desc_count; ++i) {
+            if (g_descs[i].id != id) continue;
+            if (op == CDEX_NEGO_OP_REQUEST) {
+                uint8_t reply[LOADGEN_MAX_FRAME];
+                int reply_len = cdex_nego_encode_control(CDEX_NEGO_OP_DESCRIPTOR, id, g_descs[i].descriptor_string,
+                                                         reply, sizeof(reply));
+                if (reply_len > 0) send(fd, reply, (size_t)reply_len, 0);
+            } else if (op == CDEX_NEGO_OP_ACK) {
+                g_descs[i].acked = true;
+            }
+            break;
+        }
+    }
+    return handled;
+}
+
+static bool all_acked(void) {
+    for (int i = 0; i < g_desc_count; ++i) {
+        if (!g_descs[i].acked) return false;
+    }
+    return true;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -h <addr>     target address (default 127.0.0.1)\n"
+            "  -p <port>     target UDP port (default 9000)\n"
+            "  -d <file>     descriptors, one \"<id> <descriptor>\" per line (default: built-in)\n"
+            "  -c <n>        source sockets, i.e. simulated devices (default 8)\n"
+            "  -k <n>        distinct frames to pre-generate (default 1024)\n"
+            "  -n <n>        packets to send (default 1000000)\n"
+            "  -r <pps>      target rate in packets/sec, 0 for maximum (default 0)\n"
+            "  -S            skip the descriptor handshake before the run\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    const char* host = "127.0.0.1";
+    int port = 9000;
+    const char* desc_path = NULL;
+    int socket_count = 8;
+    int frame_count = 1024;
+    uint64_t total = 1000000;
+    uint64_t rate = 0;
+    bool handshake = true;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:d:c:k:n:r:S")) != -1) {
+        switch (opt) {
+            case 'h': host = optarg; break;
+            case 'p': port = atoi(optarg); break;
+            case 'd': desc_path = optarg; break;
+            case 'c': socket_count = atoi(optarg); break;
+            case 'k': frame_count = atoi(optarg); break;
+            case 'n': total = strtoull(optarg, NULL, 0); break;
+            case 'r': rate = strtoull(optarg, NULL, 0); break;
+            case 'S': handshake = false; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (socket_count < 1 || socket_count > LOADGEN_MAX_SOCKETS || frame_count < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    cdex_manager_init();
+    if (desc_path) {
+        if (load_descriptor_file(desc_path) <= 0) return 1;
+    } else {
+        for (size_t i = 0; i < sizeof(g_default_descriptors) / sizeof(g_default_descriptors[0]); ++i) {
+            add_descriptor((uint16_t)(0x1001 + i), g_default_descriptors[i]);
+        }
+    }
+
+    // 预先打包，发送循环中不做编码
+    uint8_t (*frames)[LOADGEN_MAX_FRAME] = malloc((size_t)frame_count * LOADGEN_MAX_FRAME);
+    int* lens = malloc((size_t)frame_count * sizeof(int));
+    if (!frames || !lens) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (int k = 0; k < frame_count; ++k) {
+        lens[k] = make_frame(g_descs[k % g_desc_count].id, frames[k], LOADGEN_MAX_FRAME);
+        if (lens[k] <= 0) {
+            fprintf(stderr, "failed to pack frame for descriptor 0x%04X\n", g_descs[k % g_desc_count].id);
+            return 1;
+        }
+    }
+
+    struct sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &target.sin_addr) != 1) {
+        fprintf(stderr, "invalid address: %s\n", host);
+        return 1;
+    }
+    int fds[LOADGEN_MAX_SOCKETS];
+    for (int s = 0; s < socket_count; ++s) {
+        fds[s] = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fds[s] < 0 || connect(fds[s], (struct sockaddr*)&target, sizeof(target)) < 0) {
+            perror("socket");
+            return 1;
+        }
+    }
+
+    if (handshake) {
+        // 每个描述符先发一帧，等待接收端完成注册，避免测量期间帧在协商队列中溢出
+        for (int i = 0; i < g_desc_count && i < frame_count; ++i) {
+            send(fds[0], frames[i], (size_t)lens[i], 0);
+        }
+        uint64_t deadline = now_ns() + 2000000000ULL;
+        while (!all_acked() && now_ns() < deadline) {
+            serve_control(fds[0]);
+            struct timespec nap = {0, 1000000};
+            nanosleep(&nap, NULL);
+        }
+        if (!all_acked()) {
+            fprintf(stderr, "handshake timed out, is cdex_ingestd running on %s:%d?\n", host, port);
+            return 1;
+        }
+    }
+
+    struct mmsghdr msgs[LOADGEN_BATCH];
+    struct iovec iovs[LOADGEN_BATCH];
+    uint64_t sent = 0, dropped = 0, control = 0;
+    uint64_t batch_ns = rate ? (uint64_t)LOADGEN_BATCH * 1000000000ULL / rate : 0;
+    int next_frame = 0;
+    uint64_t start = now_ns();
+    uint64_t next_deadline = start;
+
+    for (uint64_t batch = 0; sent + dropped < total; ++batch) {
+        int fd = fds[batch % (uint64_t)socket_count];
+        int count = (int)(total - sent - dropped < LOADGEN_BATCH ? total - sent - dropped : LOADGEN_BATCH);
+        for (int i = 0; i < count; ++i) {
+            iovs[i].iov_base = frames[next_frame];
+            iovs[i].iov_len = (size_t)lens[next_frame];
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            next_frame = (next_frame + 1) % frame_count;
+        }
+        int n = sendmmsg(fd, msgs, (unsigned int)count, 0);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != ENOBUFS && errno != ECONNREFUSED && errno != EINTR) {
+                perror("sendmmsg");
+                break;
+            }
+            n = 0;
+        }
+        sent += (uint64_t)n;
+        dropped += (uint64_t)(count - n);
+
+        if ((batch & 63) == 0) {
+            for (int s = 0; s < socket_count; ++s) control += (uint64_t)serve_control(fds[s]);
+        }
+        if (batch_ns) {
+            next_deadline += batch_ns;
+            struct timespec ts = { (time_t)(next_deadline / 1000000000ULL), (long)(next_deadline % 1000000000ULL) };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+    for (int s = 0; s < socket_count; ++s) control += (uint64_t)serve_control(fds[s]);
+
+    double seconds = elapsed / 1e9;
+    fprintf(stderr, "sent=%llu dropped=%llu control=%llu elapsed=%.3fs rate=%.0f pkt/s\n",
+            (unsigned long long)sent, (unsigned long long)dropped, (unsigned long long)control,
+            seconds, seconds > 0 ? sent / seconds : 0.0);
+
+    for (int s = 0; s < socket_count; ++s) close(fds[s]);
+    for (int i = 0; i < g_desc_count; ++i) free(g_descs[i].descriptor_string);
+    free(frames);
+    free(lens);
+    cdex_manager_cleanup();
+    return 0;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file cdex_replay.c
+ * @brief 抓包文件的查看、解码与回放工具
+ *
+ * 抓包文件由 cdex_ingestd -c 或 cdex_capture_* 接口写出。工具按描述符ID和时间范围筛选记录，
+ * 然后三选一：通过 UDP 按原始节奏或最大速度重放；解码为 NDJSON；或者只解码并统计吞吐，
+ * 用于对比解析性能。帧直接从 mmap 区域交给 cdex_parse，不做拷贝。
+ *
+ * 含 dstr 字段的描述符各自绑定一个接收字典。-s 跳过的记录中带内新增的条目会先应用到字典，
+ * 解码结果与从头读取一致。抓包记录不含来源地址，多个发送方共用描述符时字典索引可能冲突。
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "cdex.h"
+#include "cdex_capture.h"
+#include "cjson/cJSON.h"
+
+#define REPLAY_BATCH 64
+#define REPLAY_MAX_DICTS 256
+
+static cdex_dict_t* g_dicts[REPLAY_MAX_DICTS];
+static uint16_t g_dict_ids[REPLAY_MAX_DICTS];
+static int g_dict_count;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t deadline) {
+    struct timespec ts = { (time_t)(deadline / 1000000000ULL), (long)(deadline % 1000000000ULL) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+/**
+ * @brief 按原始节奏回放时记录的发送时刻，早于首条记录的乱序时间戳立即发送
+ */
+static uint64_t replay_due(uint64_t start, uint64_t first_ts, uint64_t ts, double speed) {
+    return start + (ts > first_ts ? (uint64_t)((ts - first_ts) / speed) : 0);
+}
+
+static bool has_dict_fields(const cdex_descriptor_t* desc) {
+    for (int i = 0; i < desc->field_count; ++i) {
+        if (desc->fields[i].type == CDEX_TYPE_DSTR) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 为含 dstr 字段的描述符绑定接收字典
+ */
+static int bind_dict(uint16_t id) {
+    if (!has_dict_fields(cdex_get_descriptor_by_id(id))) return 0;
+    if (g_dict_count >= REPLAY_MAX_DICTS) return -1;
+    cdex_dict_t* dict = malloc(sizeof(cdex_dict_t));
+    if (!dict) return -1;
+    cdex_dict_init(dict, false);
+    cdex_descriptor_bind_dict(id, dict);
+    g_dicts[g_dict_count] = dict;
+    g_dict_ids[g_dict_count++] = id;
+    return 0;
+}
+
+static bool is_selected(uint16_t id, const uint16_t* ids, int id_count) {
+    if (id_count == 0) return true;
+    for (int i = 0; i < id_count; ++i) {
+        if (ids[i] == id) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 选中的描述符中含 dstr 字段的ID
+ * @return ID个数，超过 CDEX_CAPTURE_MAX_QUERY_IDS 时返回-1
+ */
+static int selected_dict_ids(const uint16_t* ids, int id_count, uint16_t* dict_ids) {
+    int count = 0;
+    for (int i = 0; i < g_dict_count; ++i) {
+        if (!is_selected(g_dict_ids[i], ids, id_count)) continue;
+        if (count >= CDEX_CAPTURE_MAX_QUERY_IDS) return -1;
+        dict_ids[count++] = g_dict_ids[i];
+    }
+    return count;
+}
+
+/**
+ * @brief 解析 -s 跳过的记录，只为把其中带内新增的字典条目应用到接收字典
+ */
+static cdex_status_t prime_dicts(const cdex_capture_reader_t* reader, const uint16_t* dict_ids, int count,
+                                 uint64_t end_ns) {
+    cdex_capture_cursor_t cursor;
+    cdex_status_t status = cdex_capture_cursor_init(&cursor, reader, dict_ids, count, 0, end_ns);
+    if (status != CDEX_SUCCESS) return status;
+    uint64_t ts;
+    const uint8_t* frame;
+    size_t len;
+    while (cdex_capture_next(&cursor, &ts, &frame, &len)) {
+        cdex_packet_t packet;
+        cdex_parse(frame, len, &packet);
+        cdex_free_packet_memory(&packet);
+    }
+    return CDEX_SUCCESS;
+}
+
+/**
+ * @brief 加载描述符文件，格式与 cdex_ingestd -d 相同
+ */
+static int load_descriptor_file(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+    char line[1024];
+    int loaded = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* end;
+        unsigned long id = strtoul(line, &end, 0);
+        if (end == line || line[0] == '#') continue;
+        while (*end == ' ' || *end == '\t') end++;
+        if (id > 0xFFFF || *end == '\0' ||
+            cdex_descriptor_register((uint16_t)id, end) != CDEX_SUCCESS) {
+            fprintf(stderr, "skip invalid descriptor line: %s\n", line);
+            continue;
+        }
+        if (bind_dict((uint16_t)id) != 0) {
+            fprintf(stderr, "too many dstr descriptors, at most %d\n", REPLAY_MAX_DICTS);
+            fclose(file);
+            return -1;
+        }
+        loaded++;
+    }
+    fclose(file);
+    return loaded;
+}
+
+static int parse_id_list(char* list, uint16_t* ids) {
+    int count = 0;
+    for (char* token = strtok(list, ","); token; token = strtok(NULL, ",")) {
+        char* end;
+        unsigned long id = strtoul(token, &end, 0);
+        if (end == token || *end != '\0' || id > 0xFFFF || count >= CDEX_CAPTURE_MAX_QUERY_IDS) return -1;
+        ids[count++] = (uint16_t)id;
+    }
+    return count;
+}
+
+static void list_index(const cdex_capture_reader_t* reader) {
+    uint64_t first, last;
+    if (!cdex_capture_time_range(reader, &first, &last)) {
+        printf("empty capture\n");
+        return;
+    }
+    printf("time range: %.3f s (%llu .. %llu ns)\n", (last - first) / 1e9,
+           (unsigned long long)first, (unsigned long long)last);
+    if (!reader->indexed) {
+        printf("no index (capture was not closed cleanly), records are read sequentially\n");
+        return;
+    }
+    uint64_t records = 0;
+    for (uint32_t i = 0; i < reader->block_count; ++i) records += reader->blocks[i].record_count;
+    printf("records: %llu in %u blocks, %u descriptors\n", (unsigned long long)records,
+           reader->block_count, reader->desc_count);
+    printf("%-8s %12s %8s %14s %14s\n", "id", "records", "blocks", "first (s)", "last (s)");
+    for (uint32_t i = 0; i < reader->desc_count; ++i) {
+        const cdex_capture_desc_t* desc = &reader->descs[i];
+        printf("0x%04X   %12u %8u %14.3f %14.3f\n", desc->descriptor_id, desc->record_count, desc->list_len,
+               (desc->first_ns - first) / 1e9, (desc->last_ns - first) / 1e9);
+    }
+}
+
+static void print_json(const cdex_packet_t* packet, uint64_t timestamp_ns) {
+    cJSON* json = cdex_packet_to_json(packet);
+    if (!json) return;
+    cJSON_AddNumberToObject(json, "capture_ns", (double)timestamp_ns);
+    char* line = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (!line) return;
+    fputs(line, stdout);
+    fputc('\n', stdout);
+    free(line);
+}
+
+static int open_target(const char* spec, struct sockaddr_in* target) {
+    char host[64];
+    const char* colon = strrchr(spec, ':');
+    if (!colon || (size_t)(colon - spec) >= sizeof(host)) return -1;
+    memcpy(host, spec, (size_t)(colon - spec));
+    host[colon - spec] = '\0';
+    memset(target, 0, sizeof(*target));
+    target->sin_family = AF_INET;
+    target->sin_port = htons((uint16_t)atoi(colon + 1));
+    if (inet_pton(AF_INET, host, &target->sin_addr) != 1) return -1;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)target, sizeof(*target)) < 0) return -1;
+    return fd;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <capture file>\n"
+            "  -l            list the capture index and exit\n"
+            "  -i <ids>      comma separated descriptor IDs to keep (default all)\n"
+            "  -s <sec>      skip records before <sec> seconds after the first record\n"
+            "  -e <sec>      stop after <sec> seconds after the first record\n"
+            "  -u <ip:port>  replay frames over UDP\n"
+            "  -x <factor>   replay speed, 1 = original timing, 0 = maximum (default 1)\n"
+            "  -d <file>     descriptors, one \"<id> <descriptor>\" per line; dstr descriptors\n"
+            "                cannot be combined with -s and -u\n"
+            "  -j            decode and print NDJSON to stdout\n"
+            "Without -u the selected frames are decoded as fast as possible and the\n"
+            "throughput is reported; decoding requires -d.\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    bool list = false, json = false;
+    uint16_t ids[CDEX_CAPTURE_MAX_QUERY_IDS];
+    int id_count = 0;
+    double start_sec = 0, end_sec = 0;
+    const char* udp_target = NULL;
+    const char* desc_path = NULL;
+    double speed = 1.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "li:s:e:u:x:d:jh")) != -1) {
+        switch (opt) {
+            case 'l': list = true; break;
+            case 'i':
+                id_count = parse_id_list(optarg, ids);
+                if (id_count < 0) {
+                    fprintf(stderr, "invalid ID list, at most %d IDs\n", CDEX_CAPTURE_MAX_QUERY_IDS);
+                    return 1;
+                }
+                break;
+            case 's': start_sec = atof(optarg); break;
+            case 'e': end_sec = atof(optarg); break;
+            case 'u': udp_target = optarg; break;
+            case 'x': speed = atof(optarg); break;
+            case 'd': desc_path = optarg; break;
+            case 'j': json = true; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || speed < 0 || (!list && !udp_target && !desc_path) || (json && udp_target)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    cdex_capture_reader_t reader;
+    cdex_status_t status = cdex_capture_reader_open(&reader, argv[optind]);
+    if (status != CDEX_SUCCESS) {
+        fprintf(stderr, "cannot open capture %s (status %d)\n", argv[optind], status);
+        return 1;
+    }
+    if (list) {
+        list_index(&reader);
+        cdex_capture_reader_close(&reader);
+        return 0;
+    }
+
+    uint64_t first = 0, last = 0;
+    if (!cdex_capture_time_range(&reader, &first, &last)) {
+        cdex_capture_reader_close(&reader);
+        return 0;
+    }
+    uint64_t start_ns = first + (uint64_t)(start_sec * 1e9);
+    uint64_t end_ns = end_sec > 0 ? first + (uint64_t)(end_sec * 1e9) : 0;
+    cdex_capture_cursor_t cursor;
+    if (cdex_capture_cursor_init(&cursor, &reader, ids, id_count, start_ns, end_ns) != CDEX_SUCCESS) {
+        cdex_capture_reader_close(&reader);
+        return 1;
+    }
+
+    cdex_manager_init();
+    if (desc_path && load_descriptor_file(desc_path) < 0) return 1;
+    uint16_t dict_ids[CDEX_CAPTURE_MAX_QUERY_IDS];
+    int dict_count = selected_dict_ids(ids, id_count, dict_ids);
+    if (start_ns > first && dict_count != 0) {
+        // 回放端无法替接收方补发跳过的新增条目，解码时则先把它们应用到本地字典
+        if (udp_target) {
+            fprintf(stderr, "-s would skip in-band dictionary entries of dstr descriptors, "
+                    "exclude them with -i to replay over UDP\n");
+            return 1;
+        }
+        if (dict_count < 0 || prime_dicts(&reader, dict_ids, dict_count, start_ns - 1) != CDEX_SUCCESS) {
+            fprintf(stderr, "too many dstr descriptors to seek, select at most %d of them with -i\n",
+                    CDEX_CAPTURE_MAX_QUERY_IDS);
+            return 1;
+        }
+    }
+
+    int fd = -1;
+    struct sockaddr_in target;
+    if (udp_target) {
+        fd = open_target(udp_target, &target);
+        if (fd < 0) {
+            fprintf(stderr, "invalid UDP target: %s\n", udp_target);
+            return 1;
+        }
+    }
+
+    uint64_t timestamps[REPLAY_BATCH];
+    const uint8_t* frames[REPLAY_BATCH];
+    size_t lens[REPLAY_BATCH];
+    struct mmsghdr msgs[REPLAY_BATCH];
+    struct iovec iovs[REPLAY_BATCH];
+    uint64_t records = 0, bytes = 0, decoded = 0, errors = 0, dropped = 0;
+    uint64_t first_ts = 0;
+    uint64_t start = now_ns();
+
+    int n;
+    while ((n = cdex_capture_next_batch(&cursor, timestamps, frames, lens, REPLAY_BATCH)) > 0) {
+        if (records == 0) first_ts = timestamps[0];
+        records += (uint64_t)n;
+        for (int i = 0; i < n; ++i) bytes += lens[i];
+
+        if (udp_target) {
+            int sent = 0;
+            while (sent < n) {
+                // 按原始节奏回放时，每次只发送已到发送时刻的帧
+                int count = n - sent;
+                if (speed > 0) {
+                    uint64_t due = replay_due(start, first_ts, timestamps[sent], speed);
+                    if (due > now_ns()) sleep_until(due);
+                    uint64_t now = now_ns();
+                    count = 1;
+                    while (sent + count < n &&
+                           replay_due(start, first_ts, timestamps[sent + count], speed) <= now) {
+                        count++;
+                    }
+                }
+                for (int i = 0; i < count; ++i) {
+                    iovs[i].iov_base = (void*)frames[sent + i];
+                    iovs[i].iov_len = lens[sent + i];
+                    memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+                    msgs[i].msg_hdr.msg_iov = &iovs[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                }
+                int done = sendmmsg(fd, msgs, (unsigned int)count, 0);
+                if (done <= 0) {
+                    if (done < 0 && errno != EAGAIN && errno != ENOBUFS && errno != ECONNREFUSED &&
+                        errno != EINTR) {
+                        perror("sendmmsg");
+                        return 1;
+                    }
+                    // 丢弃本次未发出的帧，回放不重试
+                    done = count;
+                    dropped += (uint64_t)count;
+                }
+                sent += done;
+            }
+            continue;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            cdex_packet_t packet;
+            if (cdex_parse(frames[i], lens[i], &packet) == CDEX_SUCCESS) {
+                decoded++;
+                if (json) print_json(&packet, timestamps[i]);
+            } else {
+                errors++;
+            }
+            cdex_free_packet_memory(&packet);
+        }
+    }
+
+    double seconds = (now_ns() - start) / 1e9;
+    if (udp_target) {
+        fprintf(stderr, "sent=%llu dropped=%llu bytes=%llu in %.3f s (%.0f pkt/s)\n",
+                (unsigned long long)(records - dropped), (unsigned long long)dropped,
+                (unsigned long long)bytes, seconds, seconds > 0 ? records / seconds : 0.0);
+        close(fd);
+    } else {
+        fprintf(stderr, "records=%llu decoded=%llu errors=%llu bytes=%llu in %.3f s (%.0f pkt/s, %.1f MB/s)\n",
+                (unsigned long long)records, (unsigned long long)decoded, (unsigned long long)errors,
+                (unsigned long long)bytes, seconds, seconds > 0 ? records / seconds : 0.0,
+                seconds > 0 ? bytes / seconds / 1e6 : 0.0);
+    }
+    cdex_capture_reader_close(&reader);
+    cdex_manager_cleanup();
+    for (int i = 0; i < g_dict_count; ++i) free(g_dicts[i]);
+    return 0;
+}